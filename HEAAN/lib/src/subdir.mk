@@ -6,9 +6,16 @@
 CPP_SRCS += \
 ../src/BootContext.cpp \
 ../src/Ciphertext.cpp \
+../src/CiphertextNTT.cpp \
+../src/CiphertextTensor.cpp \
+../src/DFTPlan.cpp \
+../src/EncryptionPool.cpp \
 ../src/EvaluatorUtils.cpp \
 ../src/Key.cpp \
+../src/LinearTransformPlan.cpp \
+../src/MatMulPlan.cpp \
 ../src/Plaintext.cpp \
+../src/PlaintextNTT.cpp \
 ../src/Ring.cpp \
 ../src/RingMultiplier.cpp \
 ../src/Scheme.cpp \
@@ -22,9 +29,16 @@ CPP_SRCS += \
 OBJS += \
 ./src/BootContext.o \
 ./src/Ciphertext.o \
+./src/CiphertextNTT.o \
+./src/CiphertextTensor.o \
+./src/DFTPlan.o \
+./src/EncryptionPool.o \
 ./src/EvaluatorUtils.o \
 ./src/Key.o \
+./src/LinearTransformPlan.o \
+./src/MatMulPlan.o \
 ./src/Plaintext.o \
+./src/PlaintextNTT.o \
 ./src/Ring.o \
 ./src/RingMultiplier.o \
 ./src/Scheme.o \
@@ -38,9 +52,16 @@ OBJS += \
 CPP_DEPS += \
 ./src/BootContext.d \
 ./src/Ciphertext.d \
+./src/CiphertextNTT.d \
+./src/CiphertextTensor.d \
+./src/DFTPlan.d \
+./src/EncryptionPool.d \
 ./src/EvaluatorUtils.d \
 ./src/Key.d \
+./src/LinearTransformPlan.d \
+./src/MatMulPlan.d \
 ./src/Plaintext.d \
+./src/PlaintextNTT.d \
 ./src/Ring.d \
 ./src/RingMultiplier.d \
 ./src/Scheme.d \
@@ -25,8 +25,18 @@ int main(int argc, char **argv) {
 
 	if(string(argv[1]) == "Encrypt") TestScheme::testEncrypt(logq, logp, logn);
 	if(string(argv[1]) == "EncryptSingle") TestScheme::testEncryptSingle(logq, logp);
+	if(string(argv[1]) == "EncryptBatch") TestScheme::testEncryptBatch(logq, logp, logn, 16);
+	if(string(argv[1]) == "EncryptionPool") TestScheme::testEncryptionPool(logq, logp, logn, 8);
+	if(string(argv[1]) == "EncryptSymmetric") TestScheme::testEncryptSymmetric(logq, logp, logn);
 	if(string(argv[1]) == "Add") TestScheme::testAdd(logq, logp, logn);
+	if(string(argv[1]) == "SumMany") TestScheme::testSumMany(logq, logp, logn, 32);
 	if(string(argv[1]) == "Mult") TestScheme::testMult(logq, logp, logn);
+	if(string(argv[1]) == "MultNoRelin") TestScheme::testMultNoRelin(logq, logp, logn, 4);
+	if(string(argv[1]) == "InnerProduct") TestScheme::testInnerProduct(logq, logp, logn, 16);
+	if(string(argv[1]) == "MultByPlaintextNTT") TestScheme::testMultByPlaintextNTT(logq, logp, logn, 8);
+	if(string(argv[1]) == "MultByConstVec") TestScheme::testMultByConstVec(logq, logp, logn, 8);
+	if(string(argv[1]) == "MultByConst") TestScheme::testMultByConst(logq, logp, logn);
+	if(string(argv[1]) == "TwoReal") TestScheme::testTwoReal(logq, logp, logn);
 	if(string(argv[1]) == "iMult") TestScheme::testiMult(logq, logp, logn);
 
 //----------------------------------------------------------------------------------
@@ -36,6 +46,20 @@ int main(int argc, char **argv) {
 	long r = 1; ///< The amout of rotation
 	if(string(argv[1]) == "RotateFast") TestScheme::testRotateFast(logq, logp, logn, r);
 	if(string(argv[1]) == "Conjugate") TestScheme::testConjugate(logq, logp, logn);
+	if(string(argv[1]) == "RotateFastNTT") TestScheme::testRotateFastNTT(logq, logp, logn, r);
+	if(string(argv[1]) == "SumSlots") TestScheme::testSumSlots(logq, logp, logn);
+
+//----------------------------------------------------------------------------------
+//   LINEAR ALGEBRA
+//----------------------------------------------------------------------------------
+
+	if(string(argv[1]) == "LinearTransform") TestScheme::testLinearTransform(logq, logp, logn);
+	if(string(argv[1]) == "Permute") TestScheme::testPermute(logq, logp, logn);
+	if(string(argv[1]) == "MatMul") TestScheme::testMatMul(logq, logp, logn / 2);
+	if(string(argv[1]) == "Convolution") TestScheme::testConvolution(logq, logp, logn, 1);
+	if(string(argv[1]) == "ConvolutionStrided") TestScheme::testConvolution(logq, logp, logn, 2);
+	if(string(argv[1]) == "DFT") TestScheme::testDFT(logq, logp, logn);
+	if(string(argv[1]) == "Pack") TestScheme::testPack(logq, logp, logn, 4);
     
 //----------------------------------------------------------------------------------
 //   BOOTSTRAPPING
@@ -9,10 +9,10 @@
 
 #include <NTL/tools.h>
 
-Ciphertext::Ciphertext(long logp, long logq, long n) : logp(logp), logq(logq), n(n) {
+Ciphertext::Ciphertext(long logp, long logq, long n) : logp(logp), logq(logq), n(n), keepNTT(false) {
 }
 
-Ciphertext::Ciphertext(const Ciphertext& o) : logp(o.logp), logq(o.logq), n(o.n) {
+Ciphertext::Ciphertext(const Ciphertext& o) : logp(o.logp), logq(o.logq), n(o.n), keepNTT(o.keepNTT) {
 	for (long i = 0; i < N; ++i) {
 		ax[i] = o.ax[i];
 		bx[i] = o.bx[i];
@@ -20,6 +20,7 @@ Ciphertext::Ciphertext(const Ciphertext& o) : logp(o.logp), logq(o.logq), n(o.n)
 }
 
 void Ciphertext::copyParams(Ciphertext& o) {
+	freeNTT();
 	logp = o.logp;
 	logq = o.logq;
 	n = o.n;
@@ -34,13 +35,24 @@ void Ciphertext::copy(Ciphertext& o) {
 }
 
 void Ciphertext::free() {
+	freeNTT();
 	for (long i = 0; i < N; ++i) {
 		clear(ax[i]);
 		clear(bx[i]);
 	}
 }
 
+void Ciphertext::freeNTT() {
+	delete[] rax;
+	delete[] rbx;
+	rax = NULL;
+	rbx = NULL;
+	np = 0;
+}
+
 Ciphertext::~Ciphertext() {
 	delete[] ax;
 	delete[] bx;
+	delete[] rax;
+	delete[] rbx;
 }
@@ -27,6 +27,11 @@ public:
 
 	long n;
 
+	bool keepNTT; ///< if true, Scheme keeps the NTT form of ax and bx below between multiplications
+	uint64_t* rax = NULL; ///< cached NTT form of ax over np primes, NULL if not built
+	uint64_t* rbx = NULL; ///< cached NTT form of bx over np primes, NULL if not built
+	long np = 0;
+
 	Ciphertext(long logp = 0, long logq = 0, long n = 0);
 
 	Ciphertext(const Ciphertext& o);
@@ -37,6 +42,8 @@ public:
 
 	void free();
 
+	void freeNTT();
+
 	virtual ~Ciphertext();
 	
 };
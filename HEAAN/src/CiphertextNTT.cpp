@@ -0,0 +1,49 @@
+/*
+* Copyright (c) by CryptoLab inc.
+* This program is licensed under a
+* Creative Commons Attribution-NonCommercial 3.0 Unported License.
+* You should have received a copy of the license along with this
+* work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+*/
+#include "CiphertextNTT.h"
+
+#include <algorithm>
+
+CiphertextNTT::CiphertextNTT(long np, long logp, long logq, long n) : np(0), logbnd(0), logp(logp), logq(logq), n(n) {
+	resize(np);
+}
+
+CiphertextNTT::CiphertextNTT(const CiphertextNTT& o) : np(0), logbnd(o.logbnd), logp(o.logp), logq(o.logq), n(o.n) {
+	resize(o.np);
+	std::copy(o.rax, o.rax + (np << logN), rax);
+	std::copy(o.rbx, o.rbx + (np << logN), rbx);
+}
+
+void CiphertextNTT::resize(long np) {
+	if(this->np != np) {
+		delete[] rax;
+		delete[] rbx;
+		rax = np > 0 ? new uint64_t[np << logN] : NULL;
+		rbx = np > 0 ? new uint64_t[np << logN] : NULL;
+		this->np = np;
+	}
+}
+
+void CiphertextNTT::copyParams(CiphertextNTT& o) {
+	resize(o.np);
+	logbnd = o.logbnd;
+	logp = o.logp;
+	logq = o.logq;
+	n = o.n;
+}
+
+void CiphertextNTT::copy(CiphertextNTT& o) {
+	copyParams(o);
+	std::copy(o.rax, o.rax + (np << logN), rax);
+	std::copy(o.rbx, o.rbx + (np << logN), rbx);
+}
+
+CiphertextNTT::~CiphertextNTT() {
+	delete[] rax;
+	delete[] rbx;
+}
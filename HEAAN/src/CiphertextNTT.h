@@ -0,0 +1,52 @@
+/*
+* Copyright (c) by CryptoLab inc.
+* This program is licensed under a
+* Creative Commons Attribution-NonCommercial 3.0 Unported License.
+* You should have received a copy of the license along with this
+* work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+*/
+#ifndef HEAAN_CIPHERTEXTNTT_H_
+#define HEAAN_CIPHERTEXTNTT_H_
+
+#include <NTL/ZZ.h>
+
+#include "Params.h"
+
+using namespace std;
+using namespace NTL;
+
+/**
+ * Ciphertext kept in double-CRT form (residues modulo the first np primes, in NTT domain).
+ * The represented coefficients are exact integers, not reduced modulo q,
+ * so logbnd tracks how large they may have grown; Scheme reduces them back modulo q
+ * only when they would no longer fit in np primes.
+ */
+class CiphertextNTT {
+public:
+
+	uint64_t* rax = NULL;
+	uint64_t* rbx = NULL;
+
+	long np;
+	double logbnd; ///< log2 of a bound on the absolute value of the coefficients
+
+	long logp;
+	long logq;
+
+	long n;
+
+	CiphertextNTT(long np = 0, long logp = 0, long logq = 0, long n = 0);
+
+	CiphertextNTT(const CiphertextNTT& o);
+
+	void resize(long np);
+
+	void copyParams(CiphertextNTT& o);
+
+	void copy(CiphertextNTT& o);
+
+	virtual ~CiphertextNTT();
+
+};
+
+#endif
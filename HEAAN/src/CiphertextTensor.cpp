@@ -0,0 +1,50 @@
+/*
+* Copyright (c) by CryptoLab inc.
+* This program is licensed under a
+* Creative Commons Attribution-NonCommercial 3.0 Unported License.
+* You should have received a copy of the license along with this
+* work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+*/
+#include "CiphertextTensor.h"
+
+#include <NTL/tools.h>
+
+CiphertextTensor::CiphertextTensor(long logp, long logq, long n) : logp(logp), logq(logq), n(n) {
+}
+
+CiphertextTensor::CiphertextTensor(const CiphertextTensor& o) : logp(o.logp), logq(o.logq), n(o.n) {
+	for (long i = 0; i < N; ++i) {
+		ax[i] = o.ax[i];
+		bx[i] = o.bx[i];
+		abx[i] = o.abx[i];
+	}
+}
+
+void CiphertextTensor::copyParams(CiphertextTensor& o) {
+	logp = o.logp;
+	logq = o.logq;
+	n = o.n;
+}
+
+void CiphertextTensor::copy(CiphertextTensor& o) {
+	copyParams(o);
+	for (long i = 0; i < N; ++i) {
+		ax[i] = o.ax[i];
+		bx[i] = o.bx[i];
+		abx[i] = o.abx[i];
+	}
+}
+
+void CiphertextTensor::free() {
+	for (long i = 0; i < N; ++i) {
+		clear(ax[i]);
+		clear(bx[i]);
+		clear(abx[i]);
+	}
+}
+
+CiphertextTensor::~CiphertextTensor() {
+	delete[] ax;
+	delete[] bx;
+	delete[] abx;
+}
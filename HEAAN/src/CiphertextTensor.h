@@ -0,0 +1,48 @@
+/*
+* Copyright (c) by CryptoLab inc.
+* This program is licensed under a
+* Creative Commons Attribution-NonCommercial 3.0 Unported License.
+* You should have received a copy of the license along with this
+* work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+*/
+#ifndef HEAAN_CIPHERTEXTTENSOR_H_
+#define HEAAN_CIPHERTEXTTENSOR_H_
+
+#include <NTL/ZZ.h>
+
+#include "Params.h"
+
+using namespace std;
+using namespace NTL;
+
+/**
+ * Product of two ciphertexts before relinearization,
+ * decrypting to bx + abx * s + ax * s^2 mod q.
+ */
+class CiphertextTensor {
+public:
+
+	ZZ* ax = new ZZ[N]; ///< coefficient of s^2
+	ZZ* bx = new ZZ[N]; ///< constant part
+	ZZ* abx = new ZZ[N]; ///< coefficient of s
+
+	long logp;
+	long logq;
+
+	long n;
+
+	CiphertextTensor(long logp = 0, long logq = 0, long n = 0);
+
+	CiphertextTensor(const CiphertextTensor& o);
+
+	void copyParams(CiphertextTensor& o);
+
+	void copy(CiphertextTensor& o);
+
+	void free();
+
+	virtual ~CiphertextTensor();
+
+};
+
+#endif
@@ -0,0 +1,46 @@
+/*
+* Copyright (c) by CryptoLab inc.
+* This program is licensed under a
+* Creative Commons Attribution-NonCommercial 3.0 Unported License.
+* You should have received a copy of the license along with this
+* work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+*/
+#include "DFTPlan.h"
+
+#include <algorithm>
+
+DFTPlan::DFTPlan(long slots, bool isInverse, long logp, long logq) : stages(NULL), nstages(0), slots(slots), isInverse(isInverse), logp(logp), logq(logq) {
+}
+
+void DFTPlan::resize(long nstages) {
+	for (long s = 0; s < this->nstages; ++s) {
+		delete stages[s];
+	}
+	delete[] stages;
+	stages = nstages > 0 ? new LinearTransformPlan*[nstages] : NULL;
+	for (long s = 0; s < nstages; ++s) {
+		stages[s] = new LinearTransformPlan();
+	}
+	this->nstages = nstages;
+}
+
+/**
+ * Distinct nonzero left rotations whose keys the transform needs.
+ */
+vector<long> DFTPlan::rotations() {
+	vector<long> res;
+	for (long s = 0; s < nstages; ++s) {
+		vector<long> rots = stages[s]->rotations();
+		res.insert(res.end(), rots.begin(), rots.end());
+	}
+	sort(res.begin(), res.end());
+	res.erase(unique(res.begin(), res.end()), res.end());
+	return res;
+}
+
+DFTPlan::~DFTPlan() {
+	for (long s = 0; s < nstages; ++s) {
+		delete stages[s];
+	}
+	delete[] stages;
+}
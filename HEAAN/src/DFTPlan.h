@@ -0,0 +1,46 @@
+/*
+* Copyright (c) by CryptoLab inc.
+* This program is licensed under a
+* Creative Commons Attribution-NonCommercial 3.0 Unported License.
+* You should have received a copy of the license along with this
+* work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+*/
+#ifndef HEAAN_DFTPLAN_H_
+#define HEAAN_DFTPLAN_H_
+
+#include <NTL/ZZ.h>
+#include <vector>
+
+#include "LinearTransformPlan.h"
+
+using namespace std;
+using namespace NTL;
+
+/**
+ * Slot DFT X_k = sum_j x_j * exp(-+2 pi i j k / slots) factored as a bit reversal
+ * followed by radix-2 butterfly stages, each stage a linear transform with three diagonals.
+ * Merging stages trades depth for more diagonals per stage.
+ */
+class DFTPlan {
+public:
+
+	LinearTransformPlan** stages; ///< applied in order, stages[0] is the bit reversal
+	long nstages;
+
+	long slots;
+	bool isInverse; ///< inverse transform, including the division by slots
+
+	long logp;
+	long logq; ///< largest ciphertext modulus bits the plan can be applied to
+
+	DFTPlan(long slots = 0, bool isInverse = false, long logp = 0, long logq = 0);
+
+	void resize(long nstages);
+
+	vector<long> rotations();
+
+	virtual ~DFTPlan();
+
+};
+
+#endif
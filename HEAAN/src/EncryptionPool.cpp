@@ -0,0 +1,120 @@
+/*
+* Copyright (c) by CryptoLab inc.
+* This program is licensed under a
+* Creative Commons Attribution-NonCommercial 3.0 Unported License.
+* You should have received a copy of the license along with this
+* work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+*/
+#include "EncryptionPool.h"
+
+EncryptionPool::EncryptionPool(Scheme& scheme, long logq, long capacity, long numThreads) : scheme(scheme), logq(logq), capacity(capacity),
+		running(true), pending(0), hitCount(0), missCount(0), refillCount(0) {
+	for (long i = 0; i < numThreads; ++i) {
+		workers.push_back(thread(&EncryptionPool::refill, this));
+	}
+}
+
+void EncryptionPool::encrypt(Ciphertext& cipher, complex<double>* vals, long n, long logp) {
+	Ciphertext* zero = take();
+	if(zero == NULL) {
+		scheme.encrypt(cipher, vals, n, logp, logq);
+		return;
+	}
+	ZZ* mx = new ZZ[N];
+	scheme.ring.encode(mx, vals, n, logp);
+	addMsgAndEqual(cipher, zero, mx, n, logp);
+	delete[] mx;
+}
+
+void EncryptionPool::encrypt(Ciphertext& cipher, double* vals, long n, long logp) {
+	Ciphertext* zero = take();
+	if(zero == NULL) {
+		scheme.encrypt(cipher, vals, n, logp, logq);
+		return;
+	}
+	ZZ* mx = new ZZ[N];
+	scheme.ring.encode(mx, vals, n, logp);
+	addMsgAndEqual(cipher, zero, mx, n, logp);
+	delete[] mx;
+}
+
+long EncryptionPool::size() {
+	lock_guard<mutex> lock(mtx);
+	return pool.size();
+}
+
+long EncryptionPool::hits() {
+	lock_guard<mutex> lock(mtx);
+	return hitCount;
+}
+
+long EncryptionPool::misses() {
+	lock_guard<mutex> lock(mtx);
+	return missCount;
+}
+
+long EncryptionPool::refills() {
+	lock_guard<mutex> lock(mtx);
+	return refillCount;
+}
+
+Ciphertext* EncryptionPool::take() {
+	Ciphertext* zero = NULL;
+	{
+		lock_guard<mutex> lock(mtx);
+		if(pool.empty()) {
+			missCount++;
+		} else {
+			zero = pool.front();
+			pool.pop_front();
+			hitCount++;
+		}
+	}
+	cond.notify_one();
+	return zero;
+}
+
+void EncryptionPool::addMsgAndEqual(Ciphertext& cipher, Ciphertext* zero, ZZ* mx, long n, long logp) {
+	cipher.freeNTT();
+	swap(cipher.ax, zero->ax);
+	swap(cipher.bx, zero->bx);
+	delete zero;
+	cipher.logp = logp;
+	cipher.logq = logq;
+	cipher.n = n;
+	scheme.ring.addAndEqual(cipher.bx, mx, scheme.ring.qpows[logq]);
+}
+
+void EncryptionPool::refill() {
+	Plaintext plain(0, logq, 1);
+	while(true) {
+		{
+			unique_lock<mutex> lock(mtx);
+			cond.wait(lock, [this] { return !running || (long)pool.size() + pending < capacity; });
+			if(!running) return;
+			pending++;
+		}
+		Ciphertext* zero = new Ciphertext();
+		scheme.encryptMsg(*zero, plain);
+		{
+			lock_guard<mutex> lock(mtx);
+			pending--;
+			pool.push_back(zero);
+			refillCount++;
+		}
+	}
+}
+
+EncryptionPool::~EncryptionPool() {
+	{
+		lock_guard<mutex> lock(mtx);
+		running = false;
+	}
+	cond.notify_all();
+	for (size_t i = 0; i < workers.size(); ++i) {
+		workers[i].join();
+	}
+	for (size_t i = 0; i < pool.size(); ++i) {
+		delete pool[i];
+	}
+}
@@ -0,0 +1,70 @@
+/*
+* Copyright (c) by CryptoLab inc.
+* This program is licensed under a
+* Creative Commons Attribution-NonCommercial 3.0 Unported License.
+* You should have received a copy of the license along with this
+* work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+*/
+#ifndef HEAAN_ENCRYPTIONPOOL_H_
+#define HEAAN_ENCRYPTIONPOOL_H_
+
+#include <complex>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "Scheme.h"
+
+using namespace std;
+using namespace NTL;
+
+/**
+ * Pool of fresh encryptions of zero at level logq, refilled by background threads.
+ * encrypt takes one of them and adds the encoded message, falling back to
+ * Scheme::encrypt when the pool is empty.
+ */
+class EncryptionPool {
+public:
+
+	Scheme& scheme;
+
+	long logq; ///< level of the pooled ciphertexts
+	long capacity; ///< number of ciphertexts kept ready
+
+	EncryptionPool(Scheme& scheme, long logq, long capacity, long numThreads = 1);
+
+	void encrypt(Ciphertext& cipher, complex<double>* vals, long n, long logp);
+
+	void encrypt(Ciphertext& cipher, double* vals, long n, long logp);
+
+	long size(); ///< ciphertexts currently in the pool
+
+	long hits(); ///< encryptions served from the pool
+
+	long misses(); ///< encryptions that found the pool empty
+
+	long refills(); ///< encryptions of zero produced by the background threads
+
+	virtual ~EncryptionPool();
+
+private:
+
+	deque<Ciphertext*> pool;
+	vector<thread> workers;
+	mutex mtx;
+	condition_variable cond;
+	bool running;
+	long pending;
+	long hitCount, missCount, refillCount;
+
+	Ciphertext* take();
+
+	void addMsgAndEqual(Ciphertext& cipher, Ciphertext* zero, ZZ* mx, long n, long logp);
+
+	void refill();
+
+};
+
+#endif
@@ -18,7 +18,7 @@
 
 
 double EvaluatorUtils::randomReal(double bound)  {
-	return (double) rand()/(RAND_MAX) * bound;
+	return ldexp((double) RandomBits_ulong(53), -53) * bound;
 }
 
 complex<double> EvaluatorUtils::randomComplex(double bound) {
@@ -67,13 +67,32 @@ complex<double>* EvaluatorUtils::randomCircleArray(long n, double bound) {
 
 
 double EvaluatorUtils::scaleDownToReal(const ZZ& x, const long logp) {
-	RR xp = to_RR(x);
-	xp.e -= logp;
-	return to_double(xp);
+	long bits = NumBits(x);
+	if(bits <= 64) {
+		return ldexp(to_double(x), -logp);
+	}
+	// only the top limbs reach the double mantissa, and the shift keeps to_double away from overflow
+	ZZ top = x >> (bits - 64);
+	return ldexp(to_double(top), bits - 64 - logp);
 }
 
 ZZ EvaluatorUtils::scaleUpToZZ(const double x, const long logp) {
-	return scaleUpToZZ(to_RR(x), logp);
+	ZZ res;
+	scaleUpToZZ(res, x, logp);
+	return res;
+}
+
+void EvaluatorUtils::scaleUpToZZ(ZZ& res, const double x, const long logp) {
+	int e;
+	double m = frexp(x, &e);
+	long shift = e + logp - 53;
+	if(shift < 0) {
+		// |x| * 2^logp < 2^53, below which doubles hold every integer, so llround is exact
+		conv(res, (long) llround(ldexp(x, logp)));
+	} else {
+		conv(res, (long) ldexp(m, 53));
+		res <<= shift;
+	}
 }
 
 ZZ EvaluatorUtils::scaleUpToZZ(const RR& x, const long logp) {
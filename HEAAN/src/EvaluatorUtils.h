@@ -45,6 +45,8 @@ public:
 
 	static ZZ scaleUpToZZ(const double x, const long logp);
 
+	static void scaleUpToZZ(ZZ& res, const double x, const long logp);
+
 	static ZZ scaleUpToZZ(const RR& x, const long logp);
 
 
@@ -10,9 +10,16 @@
 #include "Ring.h"
 #include "RingMultiplier.h"
 #include "Ciphertext.h"
+#include "CiphertextNTT.h"
+#include "CiphertextTensor.h"
+#include "DFTPlan.h"
+#include "PlaintextNTT.h"
+#include "LinearTransformPlan.h"
+#include "MatMulPlan.h"
 #include "EvaluatorUtils.h"
 #include "Scheme.h"
 #include "SchemeAlgo.h"
+#include "EncryptionPool.h"
 #include "SecretKey.h"
 #include "StringUtils.h"
 #include "TimeUtils.h"
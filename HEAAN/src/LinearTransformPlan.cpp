@@ -0,0 +1,78 @@
+/*
+* Copyright (c) by CryptoLab inc.
+* This program is licensed under a
+* Creative Commons Attribution-NonCommercial 3.0 Unported License.
+* You should have received a copy of the license along with this
+* work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+*/
+#include "LinearTransformPlan.h"
+
+#include <algorithm>
+
+LinearTransformPlan::LinearTransformPlan(long slots, long k, long logp, long logq) : diags(NULL), slots(0), k(k), logp(logp), logq(logq) {
+	resize(slots);
+}
+
+void LinearTransformPlan::resize(long slots) {
+	for (long i = 0; i < this->slots; ++i) {
+		delete diags[i];
+	}
+	delete[] diags;
+	diags = slots > 0 ? new PlaintextNTT*[slots] : NULL;
+	for (long i = 0; i < slots; ++i) {
+		diags[i] = NULL;
+	}
+	this->slots = slots;
+}
+
+/**
+ * Rotations applied to the input, 0 included if some diagonal needs it.
+ */
+vector<long> LinearTransformPlan::babySteps() {
+	vector<long> res;
+	for (long b = 0; b < k; ++b) {
+		for (long ki = 0; ki + b < slots; ki += k) {
+			if(diags[ki + b] != NULL) {
+				res.push_back(b);
+				break;
+			}
+		}
+	}
+	return res;
+}
+
+/**
+ * Rotations applied to the inner sums, 0 included if some diagonal needs it.
+ */
+vector<long> LinearTransformPlan::giantSteps() {
+	vector<long> res;
+	for (long ki = 0; ki < slots; ki += k) {
+		for (long b = 0; b < k && ki + b < slots; ++b) {
+			if(diags[ki + b] != NULL) {
+				res.push_back(ki);
+				break;
+			}
+		}
+	}
+	return res;
+}
+
+/**
+ * Distinct nonzero left rotations whose keys the plan needs.
+ */
+vector<long> LinearTransformPlan::rotations() {
+	vector<long> res = babySteps();
+	vector<long> giants = giantSteps();
+	res.insert(res.end(), giants.begin(), giants.end());
+	sort(res.begin(), res.end());
+	res.erase(unique(res.begin(), res.end()), res.end());
+	res.erase(remove(res.begin(), res.end(), 0), res.end());
+	return res;
+}
+
+LinearTransformPlan::~LinearTransformPlan() {
+	for (long i = 0; i < slots; ++i) {
+		delete diags[i];
+	}
+	delete[] diags;
+}
@@ -0,0 +1,50 @@
+/*
+* Copyright (c) by CryptoLab inc.
+* This program is licensed under a
+* Creative Commons Attribution-NonCommercial 3.0 Unported License.
+* You should have received a copy of the license along with this
+* work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+*/
+#ifndef HEAAN_LINEARTRANSFORMPLAN_H_
+#define HEAAN_LINEARTRANSFORMPLAN_H_
+
+#include <NTL/ZZ.h>
+#include <vector>
+
+#include "PlaintextNTT.h"
+
+using namespace std;
+using namespace NTL;
+
+/**
+ * Encoded diagonals of a slots x slots matrix for the baby-step giant-step
+ * evaluation res = sum_g rot(sum_b rot(x, b) * diag[g * k + b], g * k).
+ * diag[g * k + b] holds diagonal g * k + b rotated right by g * k, so that
+ * every inner sum uses the k baby-step rotations of x only.
+ */
+class LinearTransformPlan {
+public:
+
+	PlaintextNTT** diags; ///< encoded diagonals, NULL for zero diagonals
+
+	long slots;
+	long k; ///< baby-step size
+
+	long logp;
+	long logq; ///< largest ciphertext modulus bits the plan can be applied to
+
+	LinearTransformPlan(long slots = 0, long k = 0, long logp = 0, long logq = 0);
+
+	void resize(long slots);
+
+	vector<long> babySteps();
+
+	vector<long> giantSteps();
+
+	vector<long> rotations();
+
+	virtual ~LinearTransformPlan();
+
+};
+
+#endif
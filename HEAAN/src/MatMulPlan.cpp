@@ -0,0 +1,57 @@
+/*
+* Copyright (c) by CryptoLab inc.
+* This program is licensed under a
+* Creative Commons Attribution-NonCommercial 3.0 Unported License.
+* You should have received a copy of the license along with this
+* work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+*/
+#include "MatMulPlan.h"
+
+#include <algorithm>
+
+MatMulPlan::MatMulPlan(long d, long logp, long logq) : colMasks(NULL), colMasksInv(NULL), d(0), logp(logp), logq(logq) {
+	resize(d);
+}
+
+void MatMulPlan::resize(long d) {
+	for (long k = 0; k < this->d; ++k) {
+		delete colMasks[k];
+		delete colMasksInv[k];
+	}
+	delete[] colMasks;
+	delete[] colMasksInv;
+	colMasks = d > 0 ? new PlaintextNTT*[d] : NULL;
+	colMasksInv = d > 0 ? new PlaintextNTT*[d] : NULL;
+	for (long k = 0; k < d; ++k) {
+		colMasks[k] = NULL;
+		colMasksInv[k] = NULL;
+	}
+	this->d = d;
+}
+
+/**
+ * Distinct nonzero left rotations whose keys the product needs.
+ */
+vector<long> MatMulPlan::rotations() {
+	long n = d * d;
+	vector<long> res = sigma.rotations();
+	vector<long> taurots = tau.rotations();
+	res.insert(res.end(), taurots.begin(), taurots.end());
+	for (long k = 1; k < d; ++k) {
+		res.push_back(k);
+		res.push_back(n - d + k);
+		res.push_back(k * d);
+	}
+	sort(res.begin(), res.end());
+	res.erase(unique(res.begin(), res.end()), res.end());
+	return res;
+}
+
+MatMulPlan::~MatMulPlan() {
+	for (long k = 0; k < d; ++k) {
+		delete colMasks[k];
+		delete colMasksInv[k];
+	}
+	delete[] colMasks;
+	delete[] colMasksInv;
+}
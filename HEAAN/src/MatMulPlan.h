@@ -0,0 +1,48 @@
+/*
+* Copyright (c) by CryptoLab inc.
+* This program is licensed under a
+* Creative Commons Attribution-NonCommercial 3.0 Unported License.
+* You should have received a copy of the license along with this
+* work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+*/
+#ifndef HEAAN_MATMULPLAN_H_
+#define HEAAN_MATMULPLAN_H_
+
+#include <NTL/ZZ.h>
+#include <vector>
+
+#include "LinearTransformPlan.h"
+#include "PlaintextNTT.h"
+
+using namespace std;
+using namespace NTL;
+
+/**
+ * Precomputed data for the product of two d x d matrices packed row-major in d^2 slots,
+ * A * B = sum_k phi^k(sigma(A)) * psi^k(tau(B)) with phi shifting columns and psi shifting rows.
+ */
+class MatMulPlan {
+public:
+
+	LinearTransformPlan sigma; ///< A(i, j) -> A(i, i + j)
+	LinearTransformPlan tau; ///< B(i, j) -> B(i + j, j)
+
+	PlaintextNTT** colMasks; ///< colMasks[k] selects the columns j < d - k, for 0 < k < d
+	PlaintextNTT** colMasksInv; ///< colMasksInv[k] selects the columns j >= d - k, for 0 < k < d
+
+	long d;
+
+	long logp;
+	long logq; ///< largest ciphertext modulus bits the plan can be applied to
+
+	MatMulPlan(long d = 0, long logp = 0, long logq = 0);
+
+	void resize(long d);
+
+	vector<long> rotations();
+
+	virtual ~MatMulPlan();
+
+};
+
+#endif
@@ -0,0 +1,31 @@
+/*
+* Copyright (c) by CryptoLab inc.
+* This program is licensed under a
+* Creative Commons Attribution-NonCommercial 3.0 Unported License.
+* You should have received a copy of the license along with this
+* work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+*/
+#include "PlaintextNTT.h"
+
+#include <algorithm>
+
+PlaintextNTT::PlaintextNTT(long np, long logp, long logq, long n) : np(0), bnd(0), logp(logp), logq(logq), n(n) {
+	resize(np);
+}
+
+PlaintextNTT::PlaintextNTT(const PlaintextNTT& o) : np(0), bnd(o.bnd), logp(o.logp), logq(o.logq), n(o.n) {
+	resize(o.np);
+	std::copy(o.rx, o.rx + (np << logN), rx);
+}
+
+void PlaintextNTT::resize(long np) {
+	if(this->np != np) {
+		delete[] rx;
+		rx = np > 0 ? new uint64_t[np << logN] : NULL;
+		this->np = np;
+	}
+}
+
+PlaintextNTT::~PlaintextNTT() {
+	delete[] rx;
+}
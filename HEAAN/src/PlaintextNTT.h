@@ -0,0 +1,45 @@
+/*
+* Copyright (c) by CryptoLab inc.
+* This program is licensed under a
+* Creative Commons Attribution-NonCommercial 3.0 Unported License.
+* You should have received a copy of the license along with this
+* work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+*/
+#ifndef HEAAN_PLAINTEXTNTT_H_
+#define HEAAN_PLAINTEXTNTT_H_
+
+#include <NTL/ZZ.h>
+
+#include "Params.h"
+
+using namespace std;
+using namespace NTL;
+
+/**
+ * Encoded polynomial kept in NTT form over np primes, ready to multiply
+ * ciphertexts with modulus up to 2^logq without repeating CRT and NTT.
+ */
+class PlaintextNTT {
+public:
+
+	uint64_t* rx = NULL;
+
+	long np;
+	long bnd; ///< number of bits of the largest encoded coefficient
+
+	long logp;
+	long logq; ///< largest ciphertext modulus bits this plaintext can multiply
+
+	long n;
+
+	PlaintextNTT(long np = 0, long logp = 0, long logq = 0, long n = 0);
+
+	PlaintextNTT(const PlaintextNTT& o);
+
+	void resize(long np);
+
+	virtual ~PlaintextNTT();
+
+};
+
+#endif
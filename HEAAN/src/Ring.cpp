@@ -43,6 +43,28 @@ Ring::Ring() {
 	}
 	ksiPows[M] = ksiPows[0];
 
+	embPows = new complex<double>[Nh];
+	for (long lenh = 1; lenh < Nh; lenh <<= 1) {
+		long lenq = lenh << 3;
+		long gap = M / lenq;
+		for (long j = 0; j < lenh; ++j) {
+			embPows[lenh - 1 + j] = ksiPows[(rotGroup[j] % lenq) * gap];
+		}
+	}
+
+	gaussBnd = ceil(8 * sigma);
+	gaussCDT = new uint64_t[gaussBnd];
+	long double total = 1;
+	for (long x = 1; x <= gaussBnd; ++x) {
+		total += 2 * expl(-(long double)(x * x) / (2 * sigma * sigma));
+	}
+	long double cum = 1 / total;
+	gaussCDT[0] = (uint64_t)(cum * 9223372036854775808.0L);
+	for (long x = 1; x < gaussBnd; ++x) {
+		cum += 2 * expl(-(long double)(x * x) / (2 * sigma * sigma)) / total;
+		gaussCDT[x] = (uint64_t)(cum * 9223372036854775808.0L);
+	}
+
 }
 
 void Ring::arrayBitReverse(complex<double>* vals, long n) {
@@ -60,36 +82,41 @@ void Ring::arrayBitReverse(complex<double>* vals, long n) {
 
 void Ring::EMB(complex<double>* vals, long n) {
 	arrayBitReverse(vals, n);
+	double* v = reinterpret_cast<double*>(vals);
 	for (long len = 2; len <= n; len <<= 1) {
+		long lenh = len >> 1;
+		double* w = reinterpret_cast<double*>(embPows + lenh - 1);
 		for (long i = 0; i < n; i += len) {
-			long lenh = len >> 1;
-			long lenq = len << 2;
-			long gap = M / lenq;
+			double* x = v + 2 * i;
+			double* y = x + len;
 			for (long j = 0; j < lenh; ++j) {
-				long idx = ((rotGroup[j] % lenq)) * gap;
-				complex<double> u = vals[i + j];
-				complex<double> v = vals[i + j + lenh];
-				v *= ksiPows[idx];
-				vals[i + j] = u + v;
-				vals[i + j + lenh] = u - v;
+				double tr = y[2 * j] * w[2 * j] - y[2 * j + 1] * w[2 * j + 1];
+				double ti = y[2 * j] * w[2 * j + 1] + y[2 * j + 1] * w[2 * j];
+				y[2 * j] = x[2 * j] - tr;
+				y[2 * j + 1] = x[2 * j + 1] - ti;
+				x[2 * j] += tr;
+				x[2 * j + 1] += ti;
 			}
 		}
 	}
 }
 
-void Ring::EMBInvLazy(complex<double>* vals, long n) {
-	for (long len = n; len >= 1; len >>= 1) {
+void Ring::EMBInvLazy(complex<double>* vals, long n, double scale) {
+	double* v = reinterpret_cast<double*>(vals);
+	for (long len = n; len >= 2; len >>= 1) {
+		long lenh = len >> 1;
+		double s = (len == 2) ? scale : 1.0;
+		double* w = reinterpret_cast<double*>(embPows + lenh - 1);
 		for (long i = 0; i < n; i += len) {
-			long lenh = len >> 1;
-			long lenq = len << 2;
-			long gap = M / lenq;
+			double* x = v + 2 * i;
+			double* y = x + len;
 			for (long j = 0; j < lenh; ++j) {
-				long idx = (lenq - (rotGroup[j] % lenq)) * gap;
-				complex<double> u = vals[i + j] + vals[i + j + lenh];
-				complex<double> v = vals[i + j] - vals[i + j + lenh];
-				v *= ksiPows[idx];
-				vals[i + j] = u;
-				vals[i + j + lenh] = v;
+				double dr = x[2 * j] - y[2 * j];
+				double di = x[2 * j + 1] - y[2 * j + 1];
+				x[2 * j] = (x[2 * j] + y[2 * j]) * s;
+				x[2 * j + 1] = (x[2 * j + 1] + y[2 * j + 1]) * s;
+				y[2 * j] = (dr * w[2 * j] + di * w[2 * j + 1]) * s;
+				y[2 * j + 1] = (di * w[2 * j] - dr * w[2 * j + 1]) * s;
 			}
 		}
 	}
@@ -97,48 +124,44 @@ void Ring::EMBInvLazy(complex<double>* vals, long n) {
 }
 
 void Ring::EMBInv(complex<double>* vals, long n) {
-	EMBInvLazy(vals, n);
-	for (long i = 0; i < n; ++i) {
-		vals[i] /= n;
-	}
+	EMBInvLazy(vals, n, 1.0 / n);
 }
 
 void Ring::encode(ZZ* mx, double* vals, long slots, long logp) {
 	complex<double>* uvals = new complex<double>[slots];
-	long i, jdx, idx;
-	for (i = 0; i < slots; ++i) {
+	for (long i = 0; i < slots; ++i) {
 		uvals[i].real(vals[i]);
 	}
-
-	long gap = Nh / slots;
-
 	EMBInv(uvals, slots);
-
-	for (i = 0, jdx = Nh, idx = 0; i < slots; ++i, jdx += gap, idx += gap) {
-		mx[idx] = EvaluatorUtils::scaleUpToZZ(uvals[i].real(), logp);
-		mx[jdx] = EvaluatorUtils::scaleUpToZZ(uvals[i].imag(), logp);
-	}
+	scaleUpToZZ(mx, uvals, slots, logp);
 	delete[] uvals;
 }
 
 void Ring::encode(ZZ* mx, complex<double>* vals, long slots, long logp) {
 	complex<double>* uvals = new complex<double> [slots];
-	long i, jdx, idx;
 	copy(vals, vals + slots, uvals);
-	long gap = Nh / slots;
 	EMBInv(uvals, slots);
-	for (i = 0, jdx = Nh, idx = 0; i < slots; ++i, jdx += gap, idx += gap) {
-		mx[idx] = EvaluatorUtils::scaleUpToZZ(uvals[i].real(), logp);
-		mx[jdx] = EvaluatorUtils::scaleUpToZZ(uvals[i].imag(), logp);
-	}
+	scaleUpToZZ(mx, uvals, slots, logp);
 	delete[] uvals;
 }
 
+void Ring::scaleUpToZZ(ZZ* mx, complex<double>* uvals, long slots, long logp) {
+	long gap = Nh / slots;
+	NTL_EXEC_RANGE(slots, first, last);
+	for (long i = first; i < last; ++i) {
+		EvaluatorUtils::scaleUpToZZ(mx[i * gap], uvals[i].real(), logp);
+		EvaluatorUtils::scaleUpToZZ(mx[i * gap + Nh], uvals[i].imag(), logp);
+	}
+	NTL_EXEC_RANGE_END;
+}
+
 void Ring::decode(ZZ* mx, complex<double>* vals, long slots, long logp, long logq) {
 	ZZ q = qpows[logq];
 	long gap = Nh / slots;
+	NTL_EXEC_RANGE(slots, first, last);
 	ZZ tmp;
-	for (long i = 0, idx = 0; i < slots; ++i, idx += gap) {
+	for (long i = first; i < last; ++i) {
+		long idx = i * gap;
 		rem(tmp, mx[idx], q);
 		if (NumBits(tmp) == logq) tmp -= q;
 		vals[i].real(EvaluatorUtils::scaleDownToReal(tmp, logp));
@@ -147,6 +170,7 @@ void Ring::decode(ZZ* mx, complex<double>* vals, long slots, long logp, long log
 		if (NumBits(tmp) == logq) tmp -= q;
 		vals[i].imag(EvaluatorUtils::scaleDownToReal(tmp, logp));
 	}
+	NTL_EXEC_RANGE_END;
 	EMB(vals, slots);
 }
 
@@ -326,10 +350,38 @@ void Ring::CRT(uint64_t* rx, ZZ* x, const long np) {
 	multiplier.CRT(rx, x, np);
 }
 
+void Ring::CRT(uint64_t* rx, long* x, const long np) {
+	multiplier.CRT(rx, x, np);
+}
+
+void Ring::addNTT(uint64_t* rx, uint64_t* ra, uint64_t* rb, const long np) {
+	multiplier.addNTT(rx, ra, rb, np);
+}
+
 void Ring::addNTTAndEqual(uint64_t* ra, uint64_t* rb, const long np) {
 	multiplier.addNTTAndEqual(ra, rb, np);
 }
 
+void Ring::subNTT(uint64_t* rx, uint64_t* ra, uint64_t* rb, const long np) {
+	multiplier.subNTT(rx, ra, rb, np);
+}
+
+void Ring::subNTTAndEqual(uint64_t* ra, uint64_t* rb, const long np) {
+	multiplier.subNTTAndEqual(ra, rb, np);
+}
+
+void Ring::pointwiseMult(uint64_t* rx, uint64_t* ra, uint64_t* rb, const long np) {
+	multiplier.pointwiseMult(rx, ra, rb, np);
+}
+
+void Ring::pointwiseMultAndEqual(uint64_t* ra, uint64_t* rb, const long np) {
+	multiplier.pointwiseMultAndEqual(ra, rb, np);
+}
+
+void Ring::reconstructNTT(ZZ* x, uint64_t* rx, long np, const ZZ& q) {
+	multiplier.reconstructNTT(x, rx, np, q);
+}
+
 void Ring::mult(ZZ* x, ZZ* a, ZZ* b, long np, const ZZ& q) {
 	multiplier.mult(x, a, b, np, q);
 }
@@ -342,6 +394,10 @@ void Ring::multDNTT(ZZ* x, uint64_t* ra, uint64_t* rb, long np, const ZZ& q) {
 	multiplier.multDNTT(x, ra, rb, np, q);
 }
 
+void Ring::multDNTTRound(ZZ* x, uint64_t* ra, uint64_t* rb, long* e, ZZ* m, long np, const ZZ& q, long bits) {
+	multiplier.multDNTTRound(x, ra, rb, e, m, np, q, bits);
+}
+
 void Ring::multAndEqual(ZZ* a, ZZ* b, long np, const ZZ& q) {
 	multiplier.multAndEqual(a, b, np, q);
 }
@@ -358,6 +414,33 @@ void Ring::squareNTT(ZZ* x, uint64_t* ra, long np, const ZZ& q) {
 	multiplier.squareNTT(x, ra, np, q);
 }
 
+void Ring::multSparse(ZZ* x, ZZ* a, ZZ* s, const ZZ& q) {
+	vector<long> sidx;
+	vector<long> svals;
+	for (long j = 0; j < N; ++j) {
+		if(s[j] != 0) {
+			sidx.push_back(j);
+			svals.push_back(conv<long>(s[j]));
+		}
+	}
+	long h = sidx.size();
+	NTL_EXEC_RANGE(N, first, last);
+	ZZ acc;
+	for (long k = first; k < last; ++k) {
+		clear(acc);
+		for (long t = 0; t < h; ++t) {
+			long j = sidx[t];
+			if(j <= k) {
+				MulAddTo(acc, a[k - j], svals[t]);
+			} else {
+				MulSubFrom(acc, a[k - j + N], svals[t]);
+			}
+		}
+		x[k] = acc % q;
+	}
+	NTL_EXEC_RANGE_END;
+}
+
 void Ring::squareAndEqual(ZZ* a, long np, const ZZ& q) {
 	multiplier.squareAndEqual(a, np, q);
 }
@@ -494,6 +577,32 @@ void Ring::multByConstAndEqual(ZZ* p, ZZ& cnst, const ZZ& mod) {
 	}
 }
 
+/**
+ * Multiplies p by cnstr + cnsti * X^(N/2), which encodes cnstr + i * cnsti in every slot.
+ * Coefficients i and i + N/2 only depend on each other, so res may alias p.
+ */
+void Ring::multByComplexConst(ZZ* res, ZZ* p, ZZ& cnstr, ZZ& cnsti, const ZZ& mod) {
+	if(IsZero(cnsti)) {
+		multByConst(res, p, cnstr, mod);
+		return;
+	}
+	NTL_EXEC_RANGE(Nh, first, last);
+	ZZ lo, hi;
+	for (long i = first; i < last; ++i) {
+		mul(lo, p[i], cnstr);
+		MulSubFrom(lo, p[i + Nh], cnsti);
+		mul(hi, p[i + Nh], cnstr);
+		MulAddTo(hi, p[i], cnsti);
+		rem(res[i], lo, mod);
+		rem(res[i + Nh], hi, mod);
+	}
+	NTL_EXEC_RANGE_END;
+}
+
+void Ring::multByComplexConstAndEqual(ZZ* p, ZZ& cnstr, ZZ& cnsti, const ZZ& mod) {
+	multByComplexConst(p, p, cnstr, cnsti, mod);
+}
+
 void Ring::leftShift(ZZ* res, ZZ* p, const long bits, const ZZ& mod) {
 	for (long i = 0; i < N; ++i) {
 		res[i] = p[i] << bits;
@@ -557,63 +666,108 @@ void Ring::conjugate(ZZ* res, ZZ* p) {
 	}
 }
 
+void Ring::leftRotateNTT(uint64_t* rx, uint64_t* ra, long r, long np) {
+	multiplier.automorphNTT(rx, ra, rotGroup[r], np);
+}
+
+void Ring::conjugateNTT(uint64_t* rx, uint64_t* ra, long np) {
+	multiplier.automorphNTT(rx, ra, M - 1, np);
+}
+
 
 //----------------------------------------------------------------------------------
 //   SAMPLING
 //----------------------------------------------------------------------------------
 
 
-void Ring::subFromGaussAndEqual(ZZ* res, const ZZ& q) {
-	static double Pi = 4.0 * atan(1.0);
-	static long bignum = 0xfffffff;
-
-	for (long i = 0; i < N; i+=2) {
-		double r1 = (1 + RandomBnd(bignum)) / ((double)bignum + 1);
-		double r2 = (1 + RandomBnd(bignum)) / ((double)bignum + 1);
-		double theta=2 * Pi * r1;
-		double rr= sqrt(-2.0 * log(r2)) * sigma;
-
-		AddMod(res[i], -res[i], (long) floor(rr * cos(theta) + 0.5), q);
-		AddMod(res[i + 1], -res[i + 1], (long) floor(rr * sin(theta) + 0.5), q);
+void Ring::subFromGaussAndEqual(ZZ* res, const ZZ& q, RandomStream& stream) {
+	long* ex = new long[N];
+	sampleGauss(ex, stream);
+	for (long i = 0; i < N; ++i) {
+		AddMod(res[i], -res[i], ex[i], q);
 	}
+	delete[] ex;
 }
 
-void Ring::addGaussAndEqual(ZZ* res, const ZZ& q) {
-	static double Pi = 4.0 * atan(1.0);
-	static long bignum = 0xfffffff;
-
-	for (long i = 0; i < N; i+=2) {
-		double r1 = (1 + RandomBnd(bignum)) / ((double)bignum + 1);
-		double r2 = (1 + RandomBnd(bignum)) / ((double)bignum + 1);
-		double theta=2 * Pi * r1;
-		double rr= sqrt(-2.0 * log(r2)) * sigma;
+void Ring::addGaussAndEqual(ZZ* res, const ZZ& q, RandomStream& stream) {
+	long* ex = new long[N];
+	sampleGauss(ex, stream);
+	for (long i = 0; i < N; ++i) {
+		AddMod(res[i], res[i], ex[i], q);
+	}
+	delete[] ex;
+}
 
-		AddMod(res[i], res[i], (long) floor(rr * cos(theta) + 0.5), q);
-		AddMod(res[i + 1], res[i + 1], (long) floor(rr * sin(theta) + 0.5), q);
+void Ring::sampleGauss(long* res, RandomStream& stream) {
+	uint64_t* rnd = new uint64_t[N];
+	stream.get(reinterpret_cast<unsigned char*>(rnd), N * sizeof(uint64_t));
+	for (long i = 0; i < N; ++i) {
+		uint64_t r = rnd[i] >> 1;
+		long x = 0;
+		for (long j = 0; j < gaussBnd; ++j) {
+			x += (r >= gaussCDT[j]);
+		}
+		res[i] = (rnd[i] & 1) ? -x : x;
 	}
+	delete[] rnd;
 }
 
-void Ring::sampleHWT(ZZ* res) {
+void Ring::sampleHWT(ZZ* res, RandomStream& stream) {
+	unsigned char* signs = new unsigned char[(h + 7) / 8];
+	stream.get(signs, (h + 7) / 8);
+	unsigned char bytes[4];
 	long idx = 0;
-	ZZ tmp = RandomBits_ZZ(h);
 	while(idx < h) {
-		long i = RandomBits_long(logN);
+		stream.get(bytes, 4);
+		long i = ((long)bytes[0] | ((long)bytes[1] << 8) | ((long)bytes[2] << 16) | ((long)bytes[3] << 24)) & (N - 1);
 		if(res[i] == 0) {
-			res[i] = (bit(tmp, idx) == 0) ? ZZ(1) : ZZ(-1);
+			res[i] = ((signs[idx >> 3] >> (idx & 7)) & 1) == 0 ? ZZ(1) : ZZ(-1);
 			idx++;
 		}
 	}
+	delete[] signs;
 }
 
-void Ring::sampleZO(ZZ* res) {
-	ZZ tmp = RandomBits_ZZ(M);
+void Ring::sampleZO(ZZ* res, RandomStream& stream) {
+	long* vx = new long[N];
+	sampleZO(vx, stream);
 	for (long i = 0; i < N; ++i) {
-		res[i] = (bit(tmp, 2 * i) == 0) ? ZZ(0) : (bit(tmp, 2 * i + 1) == 0) ? ZZ(1) : ZZ(-1);
+		res[i] = vx[i];
 	}
+	delete[] vx;
+}
+
+void Ring::sampleZO(long* res, RandomStream& stream) {
+	unsigned char* bytes = new unsigned char[N >> 2];
+	stream.get(bytes, N >> 2);
+	for (long i = 0; i < N; ++i) {
+		long b = (bytes[i >> 2] >> ((i & 3) << 1)) & 3;
+		res[i] = ((b & 1) == 0) ? 0 : ((b & 2) == 0) ? 1 : -1;
+	}
+	delete[] bytes;
 }
 
 void Ring::sampleUniform2(ZZ* res, long bits) {
+	long nbytes = (bits + 7) / 8;
+	NTL_EXEC_RANGE(N, first, last);
+	unsigned char* bytes = new unsigned char[nbytes * (last - first)];
+	GetCurrentRandomStream().get(bytes, nbytes * (last - first));
+	for (long i = first; i < last; ++i) {
+		ZZFromBytes(res[i], bytes + (i - first) * nbytes, nbytes);
+		trunc(res[i], res[i], bits);
+	}
+	delete[] bytes;
+	NTL_EXEC_RANGE_END;
+}
+
+void Ring::sampleUniform2(ZZ* res, long bits, RandomStream& stream) {
+	long nbytes = (bits + 7) / 8;
+	unsigned char* bytes = new unsigned char[nbytes];
 	for (long i = 0; i < N; i++) {
-		res[i] = RandomBits_ZZ(bits);
+		stream.get(bytes, nbytes);
+		ZZFromBytes(res[i], bytes, nbytes);
+		trunc(res[i], res[i], bits);
 	}
+	delete[] bytes;
 }
+
@@ -27,6 +27,9 @@ public:
 	ZZ* qpows;
 	long* rotGroup;
 	complex<double>* ksiPows;
+	complex<double>* embPows; ///< twiddle factors of EMB, stage with half-length lenh stored from lenh - 1
+	long gaussBnd; ///< tail cut of the discrete Gaussian sampler
+	uint64_t* gaussCDT; ///< gaussCDT[i] = 2^63 * Pr[|e| <= i]
 	map<long, BootContext*> bootContextMap;
 	RingMultiplier multiplier;
 
@@ -42,7 +45,7 @@ public:
 
 	void EMB(complex<double>* vals, long size);
 
-	void EMBInvLazy(complex<double>* vals, long size);
+	void EMBInvLazy(complex<double>* vals, long size, double scale = 1.0);
 
 	void EMBInv(complex<double>* vals, long size);
 
@@ -50,6 +53,8 @@ public:
 
 	void encode(ZZ* mx, complex<double>* vals, long slots, long logp);
 
+	void scaleUpToZZ(ZZ* mx, complex<double>* uvals, long slots, long logp);
+
 	void decode(ZZ* mx, complex<double>* vals, long slots, long logp, long logq);
 
 
@@ -69,14 +74,30 @@ public:
 
 	void CRT(uint64_t* rx, ZZ* x, const long np);
 
+	void CRT(uint64_t* rx, long* x, const long np);
+
+	void addNTT(uint64_t* rx, uint64_t* ra, uint64_t* rb, const long np);
+
 	void addNTTAndEqual(uint64_t* ra, uint64_t* rb, const long np);
 
+	void subNTT(uint64_t* rx, uint64_t* ra, uint64_t* rb, const long np);
+
+	void subNTTAndEqual(uint64_t* ra, uint64_t* rb, const long np);
+
+	void pointwiseMult(uint64_t* rx, uint64_t* ra, uint64_t* rb, const long np);
+
+	void pointwiseMultAndEqual(uint64_t* ra, uint64_t* rb, const long np);
+
+	void reconstructNTT(ZZ* x, uint64_t* rx, long np, const ZZ& q);
+
 	void mult(ZZ* x, ZZ* a, ZZ* b, long np, const ZZ& q);
 
 	void multNTT(ZZ* x, ZZ* a, uint64_t* rb, long np, const ZZ& q);
 
 	void multDNTT(ZZ* x, uint64_t* a, uint64_t* rb, long np, const ZZ& q);
 
+	void multDNTTRound(ZZ* x, uint64_t* ra, uint64_t* rb, long* e, ZZ* m, long np, const ZZ& q, long bits);
+
 	void multAndEqual(ZZ* a, ZZ* b, long np, const ZZ& q);
 
 	void multNTTAndEqual(ZZ* a, uint64_t* rb, long np, const ZZ& q);
@@ -85,6 +106,8 @@ public:
 
 	void squareNTT(ZZ* x, uint64_t* ra, long np, const ZZ& q);
 
+	void multSparse(ZZ* x, ZZ* a, ZZ* s, const ZZ& q);
+
 	void squareAndEqual(ZZ* a, long np, const ZZ& q);
 
 
@@ -119,6 +142,10 @@ public:
 
 	void multByConstAndEqual(ZZ* p, ZZ& cnst, const ZZ& QQ);
 
+	void multByComplexConst(ZZ* res, ZZ* p, ZZ& cnstr, ZZ& cnsti, const ZZ& QQ);
+
+	void multByComplexConstAndEqual(ZZ* p, ZZ& cnstr, ZZ& cnsti, const ZZ& QQ);
+
 	void leftShift(ZZ* res, ZZ* p, const long bits, const ZZ& QQ);
 
 	void leftShiftAndEqual(ZZ* p, const long bits, const ZZ& QQ);
@@ -139,22 +166,32 @@ public:
 
 	void conjugate(ZZ* res, ZZ* p);
 
+	void leftRotateNTT(uint64_t* rx, uint64_t* ra, long r, long np);
+
+	void conjugateNTT(uint64_t* rx, uint64_t* ra, long np);
+
 
 	//----------------------------------------------------------------------------------
 	//   SAMPLING
 	//----------------------------------------------------------------------------------
 
 
-	void subFromGaussAndEqual(ZZ* res, const ZZ& q);
+	void subFromGaussAndEqual(ZZ* res, const ZZ& q, RandomStream& stream = GetCurrentRandomStream());
+
+	void addGaussAndEqual(ZZ* res, const ZZ& q, RandomStream& stream = GetCurrentRandomStream());
 
-	void addGaussAndEqual(ZZ* res, const ZZ& q);
+	void sampleGauss(long* res, RandomStream& stream = GetCurrentRandomStream());
 
-	void sampleHWT(ZZ* res);
+	void sampleHWT(ZZ* res, RandomStream& stream = GetCurrentRandomStream());
 
-	void sampleZO(ZZ* res);
+	void sampleZO(ZZ* res, RandomStream& stream = GetCurrentRandomStream());
+
+	void sampleZO(long* res, RandomStream& stream = GetCurrentRandomStream());
 
 	void sampleUniform2(ZZ* res, long bits);
 
+	void sampleUniform2(ZZ* res, long bits, RandomStream& stream);
+
 
 	//----------------------------------------------------------------------------------
 	//   DFT
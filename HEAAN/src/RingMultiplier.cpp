@@ -81,10 +81,11 @@ bool RingMultiplier::primeTest(uint64_t p) {
 	while(s % 2 == 0) {
 		s /= 2;
 	}
-	for(long i = 0; i < 200; i++) {
-		uint64_t temp1 = rand();
-		temp1  = (temp1 << 32) | rand();
-		temp1 = temp1 % (p - 1) + 1;
+	// these bases make Miller-Rabin deterministic for every 64-bit p
+	static const uint64_t bases[12] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37};
+	for(long i = 0; i < 12; i++) {
+		uint64_t temp1 = bases[i] % p;
+		if(temp1 == 0) continue;
 		uint64_t temp2 = s;
 		uint64_t mod = powMod(temp1,temp2,p);
 		while (temp2 != p - 1 && mod != 1 && mod != p - 1) {
@@ -157,6 +158,32 @@ void RingMultiplier::CRT(uint64_t* rx, ZZ* x, const long np) {
 	NTL_EXEC_RANGE_END;
 }
 
+void RingMultiplier::CRT(uint64_t* rx, long* x, const long np) {
+	NTL_EXEC_RANGE(np, first, last);
+	for (long i = first; i < last; ++i) {
+		uint64_t* rxi = rx + (i << logN);
+		uint64_t pi = pVec[i];
+		for (long n = 0; n < N; ++n) {
+			rxi[n] = (x[n] < 0) ? pi + x[n] : x[n];
+		}
+		NTT(rxi, i);
+	}
+	NTL_EXEC_RANGE_END;
+}
+
+void RingMultiplier::addNTT(uint64_t* rx, uint64_t* ra, uint64_t* rb, const long np) {
+	for (long i = 0; i < np; ++i) {
+		uint64_t* rxi = rx + (i << logN);
+		uint64_t* rai = ra + (i << logN);
+		uint64_t* rbi = rb + (i << logN);
+		uint64_t pi = pVec[i];
+		for (long n = 0; n < N; ++n) {
+			rxi[n] = rai[n] + rbi[n];
+			if(rxi[n] >= pi) rxi[n] -= pi;
+		}
+	}
+}
+
 void RingMultiplier::addNTTAndEqual(uint64_t* ra, uint64_t* rb, const long np) {
 	for (long i = 0; i < np; ++i) {
 		uint64_t* rai = ra + (i << logN);
@@ -169,6 +196,62 @@ void RingMultiplier::addNTTAndEqual(uint64_t* ra, uint64_t* rb, const long np) {
 	}
 }
 
+void RingMultiplier::subNTT(uint64_t* rx, uint64_t* ra, uint64_t* rb, const long np) {
+	for (long i = 0; i < np; ++i) {
+		uint64_t* rxi = rx + (i << logN);
+		uint64_t* rai = ra + (i << logN);
+		uint64_t* rbi = rb + (i << logN);
+		uint64_t pi = pVec[i];
+		for (long n = 0; n < N; ++n) {
+			rxi[n] = rai[n] < rbi[n] ? rai[n] + pi - rbi[n] : rai[n] - rbi[n];
+		}
+	}
+}
+
+void RingMultiplier::subNTTAndEqual(uint64_t* ra, uint64_t* rb, const long np) {
+	subNTT(ra, ra, rb, np);
+}
+
+void RingMultiplier::pointwiseMult(uint64_t* rx, uint64_t* ra, uint64_t* rb, const long np) {
+	NTL_EXEC_RANGE(np, first, last);
+	for (long i = first; i < last; ++i) {
+		uint64_t* rxi = rx + (i << logN);
+		uint64_t* rai = ra + (i << logN);
+		uint64_t* rbi = rb + (i << logN);
+		uint64_t pi = pVec[i];
+		uint64_t pri = prVec[i];
+		for (long n = 0; n < N; ++n) {
+			mulModBarrett(rxi[n], rai[n], rbi[n], pi, pri);
+		}
+	}
+	NTL_EXEC_RANGE_END;
+}
+
+void RingMultiplier::pointwiseMultAndEqual(uint64_t* ra, uint64_t* rb, const long np) {
+	pointwiseMult(ra, ra, rb, np);
+}
+
+void RingMultiplier::automorphNTT(uint64_t* rx, uint64_t* ra, long pow, const long np) {
+	// slot n of the NTT holds the evaluation at the (2 * bitReverse(n) + 1)-th power of the root,
+	// so X -> X^pow only permutes slots
+	long* idx = new long[N];
+	for (long n = 0; n < N; ++n) {
+		long e = 2 * (bitReverse(static_cast<uint32_t>(n)) >> (32 - logN)) + 1;
+		long epow = (e * pow) % M;
+		idx[n] = bitReverse(static_cast<uint32_t>(epow >> 1)) >> (32 - logN);
+	}
+	NTL_EXEC_RANGE(np, first, last);
+	for (long i = first; i < last; ++i) {
+		uint64_t* rxi = rx + (i << logN);
+		uint64_t* rai = ra + (i << logN);
+		for (long n = 0; n < N; ++n) {
+			rxi[n] = rai[idx[n]];
+		}
+	}
+	NTL_EXEC_RANGE_END;
+	delete[] idx;
+}
+
 void RingMultiplier::reconstruct(ZZ* x, uint64_t* rx, long np, const ZZ& q) {
 	ZZ* pHatnp = pHat[np - 1];
 	uint64_t* pHatInvModpnp = pHatInvModp[np - 1];
@@ -194,6 +277,20 @@ void RingMultiplier::reconstruct(ZZ* x, uint64_t* rx, long np, const ZZ& q) {
 	NTL_EXEC_RANGE_END;
 }
 
+void RingMultiplier::reconstructNTT(ZZ* x, uint64_t* rx, long np, const ZZ& q) {
+	uint64_t* ra = new uint64_t[np << logN];
+	copy(rx, rx + (np << logN), ra);
+	NTL_EXEC_RANGE(np, first, last);
+	for (long i = first; i < last; ++i) {
+		INTT(ra + (i << logN), i);
+	}
+	NTL_EXEC_RANGE_END;
+
+	reconstruct(x, ra, np, q);
+
+	delete[] ra;
+}
+
 void RingMultiplier::mult(ZZ* x, ZZ* a, ZZ* b, long np, const ZZ& mod) {
 	uint64_t* ra = new uint64_t[np << logN]();
 	uint64_t* rb = new uint64_t[np << logN]();
@@ -277,6 +374,58 @@ void RingMultiplier::multDNTT(ZZ* x, uint64_t* ra, uint64_t* rb, long np, const
 	delete[] rx;
 }
 
+/**
+ * x = round((a * b + e + m mod QQ) / 2^bits), with m optional (NULL).
+ * Error and message addition and the final rounding are done in the reconstruction pass.
+ */
+void RingMultiplier::multDNTTRound(ZZ* x, uint64_t* ra, uint64_t* rb, long* e, ZZ* m, long np, const ZZ& QQ, long bits) {
+	uint64_t* rx = new uint64_t[np << logN];
+
+	NTL_EXEC_RANGE(np, first, last);
+	for (long i = first; i < last; ++i) {
+		uint64_t* rai = ra + (i << logN);
+		uint64_t* rbi = rb + (i << logN);
+		uint64_t* rxi = rx + (i << logN);
+		uint64_t pi = pVec[i];
+		uint64_t pri = prVec[i];
+		for (long n = 0; n < N; ++n) {
+			mulModBarrett(rxi[n], rai[n], rbi[n], pi, pri);
+		}
+		INTT(rxi, i);
+	}
+	NTL_EXEC_RANGE_END;
+
+	ZZ* pHatnp = pHat[np - 1];
+	uint64_t* pHatInvModpnp = pHatInvModp[np - 1];
+	mulmod_precon_t* coeffpinv_arraynp = coeffpinv_array[np - 1];
+	ZZ& pProdnp = pProd[np - 1];
+	ZZ& pProdhnp = pProdh[np - 1];
+	ZZ half = ZZ(1) << (bits - 1);
+	NTL_EXEC_RANGE(N, first, last);
+	for (long n = first; n < last; ++n) {
+		ZZ& acc = x[n];
+		QuickAccumBegin(acc, pProdnp.size());
+		for (long i = 0; i < np; i++) {
+			long p = pVec[i];
+			long tt = pHatInvModpnp[i];
+			mulmod_precon_t ttpinv = coeffpinv_arraynp[i];
+			long s = MulModPrecon(rx[n + (i << logN)], tt, p, ttpinv);
+			QuickAccumMulAdd(acc, pHatnp[i], s);
+		}
+		QuickAccumEnd(acc);
+		rem(x[n], x[n], pProdnp);
+		if (x[n] > pProdhnp) x[n] -= pProdnp;
+		x[n] += e[n];
+		if (m != NULL) x[n] += m[n];
+		x[n] %= QQ;
+		x[n] += half;
+		x[n] >>= bits;
+	}
+	NTL_EXEC_RANGE_END;
+
+	delete[] rx;
+}
+
 void RingMultiplier::multAndEqual(ZZ* a, ZZ* b, long np, const ZZ& mod) {
 	uint64_t* ra = new uint64_t[np << logN]();
 	uint64_t* rb = new uint64_t[np << logN]();
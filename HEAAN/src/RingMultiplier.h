@@ -42,16 +42,34 @@ public:
 
 	void CRT(uint64_t* rx, ZZ* x, const long np);
 
+	void CRT(uint64_t* rx, long* x, const long np);
+
+	void addNTT(uint64_t* rx, uint64_t* ra, uint64_t* rb, const long np);
+
 	void addNTTAndEqual(uint64_t* ra, uint64_t* rb, const long np);
 
+	void subNTT(uint64_t* rx, uint64_t* ra, uint64_t* rb, const long np);
+
+	void subNTTAndEqual(uint64_t* ra, uint64_t* rb, const long np);
+
+	void pointwiseMult(uint64_t* rx, uint64_t* ra, uint64_t* rb, const long np);
+
+	void pointwiseMultAndEqual(uint64_t* ra, uint64_t* rb, const long np);
+
+	void automorphNTT(uint64_t* rx, uint64_t* ra, long pow, const long np);
+
 	void reconstruct(ZZ* x, uint64_t* rx, long np, const ZZ& QQ);
 
+	void reconstructNTT(ZZ* x, uint64_t* rx, long np, const ZZ& QQ);
+
 	void mult(ZZ* x, ZZ* a, ZZ* b, long np, const ZZ& QQ);
 
 	void multNTT(ZZ* x, ZZ* a, uint64_t* rb, long np, const ZZ& QQ);
 
 	void multDNTT(ZZ* x, uint64_t* ra, uint64_t* rb, long np, const ZZ& QQ);
 
+	void multDNTTRound(ZZ* x, uint64_t* ra, uint64_t* rb, long* e, ZZ* m, long np, const ZZ& QQ, long bits);
+
 	void multAndEqual(ZZ* a, ZZ* b, long np, const ZZ& QQ);
 
 	void multNTTAndEqual(ZZ* a, uint64_t* rb, long np, const ZZ& QQ);
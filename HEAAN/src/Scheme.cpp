@@ -7,6 +7,9 @@
 */
 #include "Scheme.h"
 
+#include <algorithm>
+#include <stdexcept>
+
 #include "NTL/BasicThreadPool.h"
 #include "StringUtils.h"
 #include "SerializationUtils.h"
@@ -16,39 +19,32 @@ Scheme::Scheme(SecretKey& secretKey, Ring& ring, bool isSerialized) : ring(ring)
 	addMultKey(secretKey);
 };
 
-void Scheme::addEncKey(SecretKey& secretKey) {
+void Scheme::addEncKey(SecretKey& secretKey, RandomStream& stream) {
 	ZZ* ax = new ZZ[N];
 	ZZ* bx = new ZZ[N];
 
 	long np = ceil((1 + logQQ + logN + 2)/(double)pbnd);
-	ring.sampleUniform2(ax, logQQ);
+	ring.sampleUniform2(ax, logQQ, stream);
 	ring.mult(bx, secretKey.sx, ax, np, QQ);
-	ring.subFromGaussAndEqual(bx, QQ);
+	ring.subFromGaussAndEqual(bx, QQ, stream);
 
 	Key* key = new Key();
 	ring.CRT(key->rax, ax, nprimes);
 	ring.CRT(key->rbx, bx, nprimes);
 	delete[] ax; delete[] bx;
 
-	if(isSerialized) {
-		string path = "serkey/ENCRYPTION.txt";
-		SerializationUtils::writeKey(key, path);
-		serKeyMap.insert(pair<long, string>(ENCRYPTION, path));
-		delete key;
-	} else {
-		keyMap.insert(pair<long, Key*>(ENCRYPTION, key));
-	}
+	insertKey(ENCRYPTION, key, "serkey/ENCRYPTION.txt");
 }
 
-void Scheme::addMultKey(SecretKey& secretKey) {
+void Scheme::addMultKey(SecretKey& secretKey, RandomStream& stream) {
 	ZZ* ax = new ZZ[N];
 	ZZ* bx = new ZZ[N];
 	ZZ* sxsx = new ZZ[N];
 
 	long np = ceil((1 + logQQ + logN + 2)/(double)pbnd);
-	ring.sampleUniform2(ax, logQQ);
+	ring.sampleUniform2(ax, logQQ, stream);
 	ring.mult(bx, secretKey.sx, ax, np, QQ);
-	ring.subFromGaussAndEqual(bx, QQ);
+	ring.subFromGaussAndEqual(bx, QQ, stream);
 
 	np = ceil((2 + logN + 2)/(double)pbnd);
 	ring.mult(sxsx, secretKey.sx, secretKey.sx, np, Q);
@@ -60,24 +56,17 @@ void Scheme::addMultKey(SecretKey& secretKey) {
 	ring.CRT(key->rax, ax, nprimes);
 	ring.CRT(key->rbx, bx, nprimes);
 	delete[] ax; delete[] bx;
-	if(isSerialized) {
-		string path = "serkey/MULTIPLICATION.txt";
-		SerializationUtils::writeKey(key, path);
-		serKeyMap.insert(pair<long, string>(MULTIPLICATION, path));
-		delete key;
-	} else {
-		keyMap.insert(pair<long, Key*>(MULTIPLICATION, key));
-	}
+	insertKey(MULTIPLICATION, key, "serkey/MULTIPLICATION.txt");
 }
 
-void Scheme::addConjKey(SecretKey& secretKey) {
+void Scheme::addConjKey(SecretKey& secretKey, RandomStream& stream) {
 	ZZ* ax = new ZZ[N];
 	ZZ* bx = new ZZ[N];
 
 	long np = ceil((1 + logQQ + logN + 2)/(double)pbnd);
-	ring.sampleUniform2(ax, logQQ);
+	ring.sampleUniform2(ax, logQQ, stream);
 	ring.mult(bx, secretKey.sx, ax, np, QQ);
-	ring.subFromGaussAndEqual(bx, QQ);
+	ring.subFromGaussAndEqual(bx, QQ, stream);
 
 	ZZ* sxconj = new ZZ[N];
 	ring.conjugate(sxconj, secretKey.sx);
@@ -90,24 +79,17 @@ void Scheme::addConjKey(SecretKey& secretKey) {
 	ring.CRT(key->rbx, bx, nprimes);
 	delete[] ax; delete[] bx;
 
-	if(isSerialized) {
-		string path = "serkey/CONJUGATION.txt";
-		SerializationUtils::writeKey(key, path);
-		serKeyMap.insert(pair<long, string>(CONJUGATION, path));
-		delete key;
-	} else {
-		keyMap.insert(pair<long, Key*>(CONJUGATION, key));
-	}
+	insertKey(CONJUGATION, key, "serkey/CONJUGATION.txt");
 }
 
-void Scheme::addLeftRotKey(SecretKey& secretKey, long r) {
+void Scheme::addLeftRotKey(SecretKey& secretKey, long r, RandomStream& stream) {
 	ZZ* ax = new ZZ[N];
 	ZZ* bx = new ZZ[N];
 
 	long np = ceil((1 + logQQ + logN + 2)/(double)pbnd);
-	ring.sampleUniform2(ax, logQQ);
+	ring.sampleUniform2(ax, logQQ, stream);
 	ring.mult(bx, secretKey.sx, ax, np, QQ);
-	ring.subFromGaussAndEqual(bx, QQ);
+	ring.subFromGaussAndEqual(bx, QQ, stream);
 
 	ZZ* spow = new ZZ[N];
 	ring.leftRotate(spow, secretKey.sx, r);
@@ -120,63 +102,133 @@ void Scheme::addLeftRotKey(SecretKey& secretKey, long r) {
 	ring.CRT(key->rbx, bx, nprimes);
 	delete[] ax; delete[] bx;
 
-	if(isSerialized) {
-		string path = "serkey/ROTATION_" + to_string(r) + ".txt";
-		SerializationUtils::writeKey(key, path);
-		serLeftRotKeyMap.insert(pair<long, string>(r, path));
-		delete key;
-	} else {
-		leftRotKeyMap.insert(pair<long, Key*>(r, key));
-	}
+	insertLeftRotKey(r, key, "serkey/ROTATION_" + to_string(r) + ".txt");
 }
 
-void Scheme::addRightRotKey(SecretKey& secretKey, long r) {
+void Scheme::addRightRotKey(SecretKey& secretKey, long r, RandomStream& stream) {
 	long idx = Nh - r;
-	if(leftRotKeyMap.find(idx) == leftRotKeyMap.end() && serLeftRotKeyMap.find(idx) == serLeftRotKeyMap.end()) {
-		addLeftRotKey(secretKey, idx);
+	if(!hasLeftRotKey(idx)) {
+		addLeftRotKey(secretKey, idx, stream);
 	}
 }
 
-void Scheme::addLeftRotKeys(SecretKey& secretKey) {
+void Scheme::addLeftRotKeys(SecretKey& secretKey, RandomStream& stream) {
 	for (long i = 0; i < logN - 1; ++i) {
 		long idx = 1 << i;
-		if(leftRotKeyMap.find(idx) == leftRotKeyMap.end() && serLeftRotKeyMap.find(idx) == serLeftRotKeyMap.end()) {
-			addLeftRotKey(secretKey, idx);
+		if(!hasLeftRotKey(idx)) {
+			addLeftRotKey(secretKey, idx, stream);
 		}
 	}
 }
 
-void Scheme::addRightRotKeys(SecretKey& secretKey) {
+void Scheme::addRightRotKeys(SecretKey& secretKey, RandomStream& stream) {
 	for (long i = 0; i < logN - 1; ++i) {
 		long idx = Nh - (1 << i);
-		if(leftRotKeyMap.find(idx) == leftRotKeyMap.end() && serLeftRotKeyMap.find(idx) == serLeftRotKeyMap.end()) {
-			addLeftRotKey(secretKey, idx);
+		if(!hasLeftRotKey(idx)) {
+			addLeftRotKey(secretKey, idx, stream);
 		}
 	}
 }
 
-void Scheme::addBootKey(SecretKey& secretKey, long logl, long logp) {
+void Scheme::addBootKey(SecretKey& secretKey, long logl, long logp, RandomStream& stream) {
 	ring.addBootContext(logl, logp);
 
-	addConjKey(secretKey);
-	addLeftRotKeys(secretKey);
+	addConjKey(secretKey, stream);
 
 	long loglh = logl/2;
 	long k = 1 << loglh;
 	long m = 1 << (logl - loglh);
 
+	vector<long> rots;
+	for (long i = 0; i < logN - 1; ++i) {
+		rots.push_back(1 << i);
+	}
 	for (long i = 1; i < k; ++i) {
-		if(leftRotKeyMap.find(i) == leftRotKeyMap.end() && serLeftRotKeyMap.find(i) == serLeftRotKeyMap.end()) {
-			addLeftRotKey(secretKey, i);
+		rots.push_back(i);
+	}
+	for (long i = 1; i < m; ++i) {
+		rots.push_back(i * k);
+	}
+	sort(rots.begin(), rots.end());
+	rots.erase(unique(rots.begin(), rots.end()), rots.end());
+
+	// every rotation key gets its own stream seeded from stream, so the keys do not depend on the thread schedule
+	unsigned char* seeds = new unsigned char[rots.size() * NTL_PRG_KEYLEN];
+	stream.get(seeds, rots.size() * NTL_PRG_KEYLEN);
+	NTL_EXEC_RANGE(rots.size(), first, last);
+	for (long i = first; i < last; ++i) {
+		if(!hasLeftRotKey(rots[i])) {
+			RandomStream rotStream(seeds + i * NTL_PRG_KEYLEN);
+			addLeftRotKey(secretKey, rots[i], rotStream);
 		}
 	}
+	NTL_EXEC_RANGE_END;
+	delete[] seeds;
+}
 
-	for (long i = 1; i < m; ++i) {
-		long idx = i * k;
-		if(leftRotKeyMap.find(idx) == leftRotKeyMap.end() && serLeftRotKeyMap.find(idx) == serLeftRotKeyMap.end()) {
-			addLeftRotKey(secretKey, idx);
+void Scheme::insertKey(long type, Key* key, string path) {
+	lock_guard<mutex> lock(keyMutex);
+	if(isSerialized) {
+		SerializationUtils::writeKey(key, path);
+		serKeyMap.insert(pair<long, string>(type, path));
+		delete key;
+	} else {
+		keyMap.insert(pair<long, Key*>(type, key));
+	}
+}
+
+void Scheme::insertLeftRotKey(long r, Key* key, string path) {
+	lock_guard<mutex> lock(keyMutex);
+	if(isSerialized) {
+		SerializationUtils::writeKey(key, path);
+		serLeftRotKeyMap.insert(pair<long, string>(r, path));
+		delete key;
+	} else {
+		leftRotKeyMap.insert(pair<long, Key*>(r, key));
+	}
+}
+
+bool Scheme::hasLeftRotKey(long r) {
+	lock_guard<mutex> lock(keyMutex);
+	return leftRotKeyMap.find(r) != leftRotKeyMap.end() || serLeftRotKeyMap.find(r) != serLeftRotKeyMap.end();
+}
+
+/**
+ * Left rotations with loaded keys adding up to r: r itself if its key is loaded,
+ * otherwise the largest loaded rotations that fit in what remains.
+ */
+vector<long> Scheme::leftRotKeySteps(long r) {
+	vector<long> res;
+	r = ((r % Nh) + Nh) % Nh;
+	if(r == 0) return res;
+	if(hasLeftRotKey(r)) {
+		res.push_back(r);
+		return res;
+	}
+	lock_guard<mutex> lock(keyMutex);
+	while(r > 0) {
+		long step = 0;
+		for (auto it = leftRotKeyMap.begin(); it != leftRotKeyMap.end() && it->first <= r; ++it) {
+			step = it->first;
+		}
+		for (auto it = serLeftRotKeyMap.begin(); it != serLeftRotKeyMap.end() && it->first <= r; ++it) {
+			step = max(step, it->first);
 		}
+		if(step == 0) step = r; // no loaded key fits, getLeftRotKey reports the missing one
+		res.push_back(step);
+		r -= step;
 	}
+	return res;
+}
+
+Key* Scheme::getKey(long type) {
+	lock_guard<mutex> lock(keyMutex);
+	return isSerialized ? SerializationUtils::readKey(serKeyMap.at(type)) : keyMap.at(type);
+}
+
+Key* Scheme::getLeftRotKey(long r) {
+	lock_guard<mutex> lock(keyMutex);
+	return isSerialized ? SerializationUtils::readKey(serLeftRotKeyMap.at(r)) : leftRotKeyMap.at(r);
 }
 
 void Scheme::encode(Plaintext& plain, double* vals, long n, long logp, long logq) {
@@ -199,6 +251,10 @@ complex<double>* Scheme::decode(Plaintext& plain) {
 	return res;
 }
 
+void Scheme::decode(complex<double>* vals, Plaintext& plain) {
+	ring.decode(plain.mx, vals, plain.n, plain.logp, plain.logq);
+}
+
 void Scheme::encodeSingle(Plaintext& plain, double val, long logp, long logq) {
 	plain.logp = logp;
 	plain.logq = logq;
@@ -229,29 +285,60 @@ complex<double> Scheme::decodeSingle(Plaintext& plain) {
 	return res;
 }
 
+void Scheme::encodeNTT(PlaintextNTT& plain, complex<double>* vals, long n, long logp, long logq) {
+	ZZ* mx = new ZZ[N];
+	ring.encode(mx, vals, n, logp);
+	encodeNTT(plain, mx, logp, logq, n);
+	delete[] mx;
+}
+
+void Scheme::encodeNTT(PlaintextNTT& plain, double* vals, long n, long logp, long logq) {
+	ZZ* mx = new ZZ[N];
+	ring.encode(mx, vals, n, logp);
+	encodeNTT(plain, mx, logp, logq, n);
+	delete[] mx;
+}
+
+void Scheme::encodeNTT(PlaintextNTT& res, Plaintext& plain) {
+	ZZ* mx = new ZZ[N];
+	ring.rightShift(mx, plain.mx, logQ);
+	encodeNTT(res, mx, plain.logp, plain.logq, plain.n);
+	delete[] mx;
+}
+
+void Scheme::encodeNTT(PlaintextNTT& plain, ZZ* mx, long logp, long logq, long n) {
+	plain.bnd = ring.maxBits(mx, N);
+	plain.logp = logp;
+	plain.logq = logq;
+	plain.n = n;
+	plain.resize(ceil((logq + plain.bnd + logN + 2)/(double)pbnd));
+	ring.CRT(plain.rx, mx, plain.np);
+}
+
 void Scheme::encryptMsg(Ciphertext& cipher, Plaintext& plain) {
+	cipher.freeNTT();
 	cipher.logp = plain.logp;
 	cipher.logq = plain.logq;
 	cipher.n = plain.n;
 	ZZ qQ = ring.qpows[plain.logq + logQ];
 
-	ZZ* vx = new ZZ[N];
-	ring.sampleZO(vx);
-
-	Key* key = isSerialized ? SerializationUtils::readKey(serKeyMap.at(ENCRYPTION)) : keyMap.at(ENCRYPTION);
+	Key* key = getKey(ENCRYPTION);
 
 	long np = ceil((1 + logQQ + logN + 2)/(double)pbnd);
-	ring.multNTT(cipher.ax, vx, key->rax, np, qQ);
-	ring.addGaussAndEqual(cipher.ax, qQ);
-
-	ring.multNTT(cipher.bx, vx, key->rbx, np, qQ);
-	ring.addGaussAndEqual(cipher.bx, qQ);
-	delete[] vx;
+	long* vx = new long[N];
+	long* ex = new long[N];
+	uint64_t* rvx = new uint64_t[np << logN];
+	ring.sampleZO(vx);
+	ring.CRT(rvx, vx, np);
 
-	ring.addAndEqual(cipher.bx, plain.mx, qQ);
+	ring.sampleGauss(ex);
+	ring.multDNTTRound(cipher.ax, rvx, key->rax, ex, NULL, np, qQ, logQ);
+	ring.sampleGauss(ex);
+	ring.multDNTTRound(cipher.bx, rvx, key->rbx, ex, plain.mx, np, qQ, logQ);
 
-	ring.rightShiftAndEqual(cipher.ax, logQ);
-	ring.rightShiftAndEqual(cipher.bx, logQ);
+	delete[] vx;
+	delete[] ex;
+	delete[] rvx;
 }
 
 void Scheme::decryptMsg(Plaintext& plain, SecretKey& secretKey, Ciphertext& cipher) {
@@ -276,17 +363,113 @@ void Scheme::encrypt(Ciphertext& cipher, double* vals, long n, long logp, long l
 	encryptMsg(cipher, plain);
 }
 
+/**
+ * Encrypts vals1 + i * vals2, so that two real vectors share the slots.
+ * Slot-wise real operations (add, real constants, rotations, real linear transforms)
+ * act on both at once; products need SchemeAlgo::multTwoReal.
+ */
+void Scheme::encryptTwoReal(Ciphertext& cipher, double* vals1, double* vals2, long n, long logp, long logq) {
+	complex<double>* vals = new complex<double>[n];
+	for (long i = 0; i < n; ++i) {
+		vals[i] = complex<double>(vals1[i], vals2[i]);
+	}
+	encrypt(cipher, vals, n, logp, logq);
+	delete[] vals;
+}
+
+void Scheme::encryptBatch(Ciphertext* ciphers, complex<double>** vals, long count, long n, long logp, long logq) {
+	NTL_EXEC_RANGE(count, first, last);
+	Plaintext plain;
+	for (long i = first; i < last; ++i) {
+		encode(plain, vals[i], n, logp, logq);
+		encryptMsg(ciphers[i], plain);
+	}
+	NTL_EXEC_RANGE_END;
+}
+
+void Scheme::encryptBatch(Ciphertext* ciphers, double** vals, long count, long n, long logp, long logq) {
+	NTL_EXEC_RANGE(count, first, last);
+	Plaintext plain;
+	for (long i = first; i < last; ++i) {
+		encode(plain, vals[i], n, logp, logq);
+		encryptMsg(ciphers[i], plain);
+	}
+	NTL_EXEC_RANGE_END;
+}
+
 void Scheme::encryptZeros(Ciphertext& cipher, long n, long logp, long logq) {
 	encryptSingle(cipher, 0.0, logp, logq);
 	cipher.n = n;
 }
 
+void Scheme::encryptSymmetric(Ciphertext& cipher, unsigned char* seed, complex<double>* vals, long n, long logp, long logq, SecretKey& secretKey) {
+	cipher.freeNTT();
+	cipher.logp = logp;
+	cipher.logq = logq;
+	cipher.n = n;
+	ZZ* mx = new ZZ[N];
+	ring.encode(mx, vals, n, logp);
+	encryptSymmetricMsg(cipher, seed, mx, secretKey);
+	delete[] mx;
+}
+
+void Scheme::encryptSymmetric(Ciphertext& cipher, unsigned char* seed, double* vals, long n, long logp, long logq, SecretKey& secretKey) {
+	cipher.freeNTT();
+	cipher.logp = logp;
+	cipher.logq = logq;
+	cipher.n = n;
+	ZZ* mx = new ZZ[N];
+	ring.encode(mx, vals, n, logp);
+	encryptSymmetricMsg(cipher, seed, mx, secretKey);
+	delete[] mx;
+}
+
+/**
+ * ax is expanded from a fresh seed of NTL_PRG_KEYLEN bytes, written to seed,
+ * and bx = mx + e - ax * s mod q, so (seed, bx) is enough to rebuild the ciphertext.
+ */
+void Scheme::encryptSymmetricMsg(Ciphertext& cipher, unsigned char* seed, ZZ* mx, SecretKey& secretKey) {
+	ZZ q = ring.qpows[cipher.logq];
+	GetCurrentRandomStream().get(seed, NTL_PRG_KEYLEN);
+	RandomStream stream(seed);
+	ring.sampleUniform2(cipher.ax, cipher.logq, stream);
+	ring.multSparse(cipher.bx, cipher.ax, secretKey.sx, q);
+	ring.subFromGaussAndEqual(cipher.bx, q);
+	ring.addAndEqual(cipher.bx, mx, q);
+}
+
 complex<double>* Scheme::decrypt(SecretKey& secretKey, Ciphertext& cipher) {
 	Plaintext plain;
 	decryptMsg(plain, secretKey, cipher);
 	return decode(plain);
 }
 
+void Scheme::decrypt(complex<double>* vals, SecretKey& secretKey, Ciphertext& cipher) {
+	Plaintext plain;
+	decryptMsg(plain, secretKey, cipher);
+	decode(vals, plain);
+}
+
+void Scheme::decryptTwoReal(double* vals1, double* vals2, SecretKey& secretKey, Ciphertext& cipher) {
+	complex<double>* vals = new complex<double>[cipher.n];
+	decrypt(vals, secretKey, cipher);
+	for (long i = 0; i < cipher.n; ++i) {
+		vals1[i] = vals[i].real();
+		vals2[i] = vals[i].imag();
+	}
+	delete[] vals;
+}
+
+void Scheme::decryptBatch(complex<double>** vals, SecretKey& secretKey, Ciphertext* ciphers, long count) {
+	NTL_EXEC_RANGE(count, first, last);
+	Plaintext plain;
+	for (long i = first; i < last; ++i) {
+		decryptMsg(plain, secretKey, ciphers[i]);
+		decode(vals[i], plain);
+	}
+	NTL_EXEC_RANGE_END;
+}
+
 void Scheme::encryptSingle(Ciphertext& cipher, complex<double> val, long logp, long logq) {
 	Plaintext plain;
 	encodeSingle(plain, val, logp, logq);
@@ -307,6 +490,35 @@ complex<double> Scheme::decryptSingle(SecretKey& secretKey, Ciphertext& cipher)
 
 //-----------------------------------------
 
+void Scheme::loadNTT(uint64_t*& ra, uint64_t*& rb, Ciphertext& cipher, long np) {
+	if(cipher.keepNTT) {
+		if(cipher.np < np) {
+			cipher.freeNTT();
+			cipher.rax = new uint64_t[np << logN];
+			cipher.rbx = new uint64_t[np << logN];
+			ring.CRT(cipher.rax, cipher.ax, np);
+			ring.CRT(cipher.rbx, cipher.bx, np);
+			cipher.np = np;
+		}
+		ra = cipher.rax;
+		rb = cipher.rbx;
+	} else {
+		ra = new uint64_t[np << logN];
+		rb = new uint64_t[np << logN];
+		ring.CRT(ra, cipher.ax, np);
+		ring.CRT(rb, cipher.bx, np);
+	}
+}
+
+void Scheme::unloadNTT(uint64_t* ra, uint64_t* rb, Ciphertext& cipher) {
+	if(ra != cipher.rax) {
+		delete[] ra;
+		delete[] rb;
+	}
+}
+
+//-----------------------------------------
+
 void Scheme::negate(Ciphertext& res, Ciphertext& cipher) {
 	res.copyParams(cipher);
 	ring.negate(res.ax, cipher.ax);
@@ -314,6 +526,7 @@ void Scheme::negate(Ciphertext& res, Ciphertext& cipher) {
 }
 
 void Scheme::negateAndEqual(Ciphertext& cipher) {
+	cipher.freeNTT();
 	ring.negateAndEqual(cipher.ax);
 	ring.negateAndEqual(cipher.bx);
 }
@@ -326,11 +539,48 @@ void Scheme::add(Ciphertext& res, Ciphertext& cipher1, Ciphertext& cipher2) {
 }
 
 void Scheme::addAndEqual(Ciphertext& cipher1, Ciphertext& cipher2) {
+	cipher1.freeNTT();
 	ZZ q = ring.qpows[cipher1.logq];
 	ring.addAndEqual(cipher1.ax, cipher2.ax, q);
 	ring.addAndEqual(cipher1.bx, cipher2.bx, q);
 }
 
+void Scheme::sumMany(Ciphertext& res, Ciphertext* ciphers, long count) {
+	if(count <= 0) {
+		throw invalid_argument("sumMany needs at least one ciphertext");
+	}
+	long logp = ciphers[0].logp;
+	long logq = ciphers[0].logq;
+	long n = ciphers[0].n;
+	for (long i = 1; i < count; ++i) {
+		if(ciphers[i].logp != logp || ciphers[i].n != n) {
+			throw invalid_argument("sumMany needs the same logp and n for all ciphertexts");
+		}
+		logq = min(logq, ciphers[i].logq);
+	}
+	ZZ q = ring.qpows[logq];
+	res.freeNTT();
+
+	// each coefficient is summed without reduction and reduced once, which also mods down to the smallest logq
+	NTL_EXEC_RANGE(N, first, last);
+	ZZ asum, bsum;
+	for (long j = first; j < last; ++j) {
+		asum = ciphers[0].ax[j];
+		bsum = ciphers[0].bx[j];
+		for (long i = 1; i < count; ++i) {
+			asum += ciphers[i].ax[j];
+			bsum += ciphers[i].bx[j];
+		}
+		res.ax[j] = asum % q;
+		res.bx[j] = bsum % q;
+	}
+	NTL_EXEC_RANGE_END;
+
+	res.logp = logp;
+	res.logq = logq;
+	res.n = n;
+}
+
 //-----------------------------------------
 
 void Scheme::addConst(Ciphertext& res, Ciphertext& cipher, double cnst, long logp) {
@@ -355,18 +605,21 @@ void Scheme::addConst(Ciphertext& res, Ciphertext& cipher, complex<double> cnst,
 }
 
 void Scheme::addConstAndEqual(Ciphertext& cipher, double cnst, long logp) {
+	cipher.freeNTT();
 	ZZ q = ring.qpows[cipher.logq];
 	ZZ cnstZZ = logp < 0 ? EvaluatorUtils::scaleUpToZZ(cnst, cipher.logp) : EvaluatorUtils::scaleUpToZZ(cnst, logp);
 	AddMod(cipher.bx[0], cipher.bx[0], cnstZZ, q);
 }
 
 void Scheme::addConstAndEqual(Ciphertext& cipher, RR& cnst, long logp) {
+	cipher.freeNTT();
 	ZZ q = ring.qpows[cipher.logq];
 	ZZ cnstZZ = logp < 0 ? EvaluatorUtils::scaleUpToZZ(cnst, cipher.logp) : EvaluatorUtils::scaleUpToZZ(cnst, logp);
 	AddMod(cipher.bx[0], cipher.bx[0], cnstZZ, q);
 }
 
 void Scheme::addConstAndEqual(Ciphertext& cipher, complex<double> cnst, long logp) {
+	cipher.freeNTT();
 	ZZ q = ring.qpows[cipher.logq];
 	ZZ cnstrZZ = logp < 0 ? EvaluatorUtils::scaleUpToZZ(cnst.real(), cipher.logp) : EvaluatorUtils::scaleUpToZZ(cnst.real(), logp);
 	ZZ cnstiZZ = logp < 0 ? EvaluatorUtils::scaleUpToZZ(cnst.imag(), cipher.logp) : EvaluatorUtils::scaleUpToZZ(cnst.imag(), logp);
@@ -384,12 +637,14 @@ void Scheme::sub(Ciphertext& res, Ciphertext& cipher1, Ciphertext& cipher2) {
 }
 
 void Scheme::subAndEqual(Ciphertext& cipher1, Ciphertext& cipher2) {
+	cipher1.freeNTT();
 	ZZ q = ring.qpows[cipher1.logq];
 	ring.subAndEqual(cipher1.ax, cipher2.ax, q);
 	ring.subAndEqual(cipher1.bx, cipher2.bx, q);
 }
 
 void Scheme::subAndEqual2(Ciphertext& cipher1, Ciphertext& cipher2) {
+	cipher2.freeNTT();
 	ZZ q = ring.qpows[cipher1.logq];
 	ring.subAndEqual2(cipher1.ax, cipher2.ax, q);
 	ring.subAndEqual2(cipher1.bx, cipher2.bx, q);
@@ -410,11 +665,13 @@ void Scheme::idiv(Ciphertext& res, Ciphertext& cipher) {
 }
 
 void Scheme::imultAndEqual(Ciphertext& cipher) {
+	cipher.freeNTT();
 	ring.multByMonomialAndEqual(cipher.ax, Nh);
 	ring.multByMonomialAndEqual(cipher.bx, Nh);
 }
 
 void Scheme::idivAndEqual(Ciphertext& cipher) {
+	cipher.freeNTT();
 	ring.multByMonomialAndEqual(cipher.ax, 3 * Nh);
 	ring.multByMonomialAndEqual(cipher.bx, 3 * Nh);
 }
@@ -428,15 +685,9 @@ void Scheme::mult(Ciphertext& res, Ciphertext& cipher1, Ciphertext& cipher2) {
 
 	long np = ceil((2 + cipher1.logq + cipher2.logq + logN + 2)/(double)pbnd);
 
-	uint64_t* ra1 = new uint64_t[np << logN];
-	uint64_t* rb1 = new uint64_t[np << logN];
-	uint64_t* ra2 = new uint64_t[np << logN];
-	uint64_t* rb2 = new uint64_t[np << logN];
-
-	ring.CRT(ra1, cipher1.ax, np);
-	ring.CRT(rb1, cipher1.bx, np);
-	ring.CRT(ra2, cipher2.ax, np);
-	ring.CRT(rb2, cipher2.bx, np);
+	uint64_t* ra1, *rb1, *ra2, *rb2;
+	loadNTT(ra1, rb1, cipher1, np);
+	loadNTT(ra2, rb2, cipher2, np);
 
 	ZZ* axax = new ZZ[N];
 	ZZ* bxbx = new ZZ[N];
@@ -444,11 +695,18 @@ void Scheme::mult(Ciphertext& res, Ciphertext& cipher1, Ciphertext& cipher2) {
 	ring.multDNTT(axax, ra1, ra2, np, q);
 	ring.multDNTT(bxbx, rb1, rb2, np, q);
 
-	ring.addNTTAndEqual(ra1, rb1, np);
-	ring.addNTTAndEqual(ra2, rb2, np);
-	ring.multDNTT(axbx, ra1, ra2, np, q);
+	uint64_t* rab1 = (ra1 == cipher1.rax) ? new uint64_t[np << logN] : ra1;
+	uint64_t* rab2 = (ra2 == cipher2.rax) ? new uint64_t[np << logN] : ra2;
+	ring.addNTT(rab1, ra1, rb1, np);
+	ring.addNTT(rab2, ra2, rb2, np);
+	ring.multDNTT(axbx, rab1, rab2, np, q);
+
+	if(rab1 != ra1) delete[] rab1;
+	if(rab2 != ra2) delete[] rab2;
+	unloadNTT(ra1, rb1, cipher1);
+	unloadNTT(ra2, rb2, cipher2);
 
-	Key* key = isSerialized ? SerializationUtils::readKey(serKeyMap.at(MULTIPLICATION)) : keyMap.at(MULTIPLICATION);
+	Key* key = getKey(MULTIPLICATION);
 
 	np = ceil((cipher1.logq + logQQ + logN + 2)/(double)pbnd);
 	uint64_t* raa = new uint64_t[np << logN];
@@ -466,10 +724,6 @@ void Scheme::mult(Ciphertext& res, Ciphertext& cipher1, Ciphertext& cipher2) {
 	delete[] axax;
 	delete[] bxbx;
 	delete[] axbx;
-	delete[] ra1;
-	delete[] ra2;
-	delete[] rb1;
-	delete[] rb2;
 	delete[] raa;
 }
 
@@ -480,15 +734,9 @@ void Scheme::multAndEqual(Ciphertext& cipher1, Ciphertext& cipher2) {
 
 	long np = ceil((2 + cipher1.logq + cipher2.logq + logN + 2)/(double)pbnd);
 
-	uint64_t* ra1 = new uint64_t[np << logN];
-	uint64_t* rb1 = new uint64_t[np << logN];
-	uint64_t* ra2 = new uint64_t[np << logN];
-	uint64_t* rb2 = new uint64_t[np << logN];
-
-	ring.CRT(ra1, cipher1.ax, np);
-	ring.CRT(rb1, cipher1.bx, np);
-	ring.CRT(ra2, cipher2.ax, np);
-	ring.CRT(rb2, cipher2.bx, np);
+	uint64_t* ra1, *rb1, *ra2, *rb2;
+	loadNTT(ra1, rb1, cipher1, np);
+	loadNTT(ra2, rb2, cipher2, np);
 
 	ZZ* axax = new ZZ[N];
 	ZZ* bxbx = new ZZ[N];
@@ -496,11 +744,20 @@ void Scheme::multAndEqual(Ciphertext& cipher1, Ciphertext& cipher2) {
 
 	ring.multDNTT(axax, ra1, ra2, np, q);
 	ring.multDNTT(bxbx, rb1, rb2, np, q);
-	ring.addNTTAndEqual(ra1, rb1, np);
-	ring.addNTTAndEqual(ra2, rb2, np);
-	ring.multDNTT(axbx, ra1, ra2, np, q);
 
-	Key* key = isSerialized ? SerializationUtils::readKey(serKeyMap.at(MULTIPLICATION)) : keyMap.at(MULTIPLICATION);
+	uint64_t* rab1 = (ra1 == cipher1.rax) ? new uint64_t[np << logN] : ra1;
+	uint64_t* rab2 = (ra2 == cipher2.rax) ? new uint64_t[np << logN] : ra2;
+	ring.addNTT(rab1, ra1, rb1, np);
+	ring.addNTT(rab2, ra2, rb2, np);
+	ring.multDNTT(axbx, rab1, rab2, np, q);
+
+	if(rab1 != ra1) delete[] rab1;
+	if(rab2 != ra2) delete[] rab2;
+	unloadNTT(ra1, rb1, cipher1);
+	unloadNTT(ra2, rb2, cipher2);
+	cipher1.freeNTT();
+
+	Key* key = getKey(MULTIPLICATION);
 
 	np = ceil((cipher1.logq + logQQ + logN + 2)/(double)pbnd);
 	uint64_t* raa = new uint64_t[np << logN];
@@ -519,10 +776,6 @@ void Scheme::multAndEqual(Ciphertext& cipher1, Ciphertext& cipher2) {
 	delete[] axax;
 	delete[] bxbx;
 	delete[] axbx;
-	delete[] ra1;
-	delete[] ra2;
-	delete[] rb1;
-	delete[] rb2;
 	delete[] raa;
 
 	cipher1.logp += cipher2.logp;
@@ -538,11 +791,8 @@ void Scheme::square(Ciphertext& res, Ciphertext& cipher) {
 
 	long np = ceil((2 * cipher.logq + logN + 2)/(double)pbnd);
 
-	uint64_t* ra = new uint64_t[np << logN];
-	uint64_t* rb = new uint64_t[np << logN];
-
-	ring.CRT(ra, cipher.ax, np);
-	ring.CRT(rb, cipher.bx, np);
+	uint64_t* ra, *rb;
+	loadNTT(ra, rb, cipher, np);
 
 	ZZ* axax = new ZZ[N];
 	ZZ* axbx = new ZZ[N];
@@ -553,7 +803,9 @@ void Scheme::square(Ciphertext& res, Ciphertext& cipher) {
 	ring.multDNTT(axbx, ra, rb, np, q);
 	ring.addAndEqual(axbx, axbx, q);
 
-	Key* key = isSerialized ? SerializationUtils::readKey(serKeyMap.at(MULTIPLICATION)) : keyMap.at(MULTIPLICATION);
+	unloadNTT(ra, rb, cipher);
+
+	Key* key = getKey(MULTIPLICATION);
 
 	np = ceil((cipher.logq + logQQ + logN + 2)/(double)pbnd);
 	uint64_t* raa = new uint64_t[np << logN];
@@ -571,8 +823,6 @@ void Scheme::square(Ciphertext& res, Ciphertext& cipher) {
 	delete[] axax;
 	delete[] bxbx;
 
-	delete[] ra;
-	delete[] rb;
 	delete[] raa;
 }
 
@@ -582,11 +832,8 @@ void Scheme::squareAndEqual(Ciphertext& cipher) {
 
 	long np = ceil((2 + 2 * cipher.logq + logN + 2)/(double)pbnd);
 
-	uint64_t* ra = new uint64_t[np << logN];
-	uint64_t* rb = new uint64_t[np << logN];
-
-	ring.CRT(ra, cipher.ax, np);
-	ring.CRT(rb, cipher.bx, np);
+	uint64_t* ra, *rb;
+	loadNTT(ra, rb, cipher, np);
 
 	ZZ* axax = new ZZ[N];
 	ZZ* axbx = new ZZ[N];
@@ -598,7 +845,10 @@ void Scheme::squareAndEqual(Ciphertext& cipher) {
 	ring.multDNTT(axbx, ra, rb, np, q);
 	ring.addAndEqual(axbx, axbx, q);
 
-	Key* key = isSerialized ? SerializationUtils::readKey(serKeyMap.at(MULTIPLICATION)) : keyMap.at(MULTIPLICATION);
+	unloadNTT(ra, rb, cipher);
+	cipher.freeNTT();
+
+	Key* key = getKey(MULTIPLICATION);
 
 	np = ceil((cipher.logq + logQQ + logN + 2)/(double)pbnd);
 
@@ -618,8 +868,6 @@ void Scheme::squareAndEqual(Ciphertext& cipher) {
 	delete[] axax;
 	delete[] bxbx;
 
-	delete[] ra;
-	delete[] rb;
 	delete[] raa;
 }
 
@@ -636,17 +884,85 @@ void Scheme::multByConst(Ciphertext& res, Ciphertext& cipher, double cnst, long
 
 void Scheme::multByConst(Ciphertext& res, Ciphertext& cipher, complex<double> cnst, long logp) {
 	ZZ q = ring.qpows[cipher.logq];
-	ZZ cnstZZ = EvaluatorUtils::scaleUpToZZ(cnst.real(), logp);
+	ZZ cnstr = EvaluatorUtils::scaleUpToZZ(cnst.real(), logp);
+	ZZ cnsti = EvaluatorUtils::scaleUpToZZ(cnst.imag(), logp);
+	ring.multByComplexConst(res.ax, cipher.ax, cnstr, cnsti, q);
+	ring.multByComplexConst(res.bx, cipher.bx, cnstr, cnsti, q);
 	res.copyParams(cipher);
-	ring.multByConst(res.ax, cipher.ax, cnstZZ, q);
-	ring.multByConst(res.bx, cipher.bx, cnstZZ, q);
 	res.logp += logp;
 }
 
 void Scheme::multByConstVec(Ciphertext& res, Ciphertext& cipher, complex<double>* cnstVec, long logp) {
+	shared_ptr<PlaintextNTT> plain = loadConstVec(cnstVec, cipher.n, logp, cipher.logq);
+	multByPoly(res, cipher, *plain);
+}
+
+void Scheme::multByConstVecAndEqual(Ciphertext& cipher, complex<double>* cnstVec, long logp) {
+	shared_ptr<PlaintextNTT> plain = loadConstVec(cnstVec, cipher.n, logp, cipher.logq);
+	multByPolyAndEqual(cipher, *plain);
+}
+
+/**
+ * All ciphers must have the same number of slots.
+ */
+void Scheme::multByConstVecBatch(Ciphertext* res, Ciphertext* ciphers, long count, complex<double>* cnstVec, long logp) {
+	if(count <= 0) return;
+	long logq = 0;
+	for (long i = 0; i < count; ++i) {
+		if(ciphers[i].n != ciphers[0].n) {
+			throw invalid_argument("ciphertexts of a batch must have the same number of slots");
+		}
+		logq = max(logq, ciphers[i].logq);
+	}
+	shared_ptr<PlaintextNTT> plain = loadConstVec(cnstVec, ciphers[0].n, logp, logq);
+	NTL_EXEC_RANGE(count, first, last);
+	for (long i = first; i < last; ++i) {
+		multByPoly(res[i], ciphers[i], *plain);
+	}
+	NTL_EXEC_RANGE_END;
+}
+
+/**
+ * Returns the encoding of cnstVec, reusing the cached one if the vector at this address
+ * still holds the same values and it was encoded for n, logp and at least logq.
+ * At most constVecCacheSize encodings are kept, evicting the least recently used.
+ */
+shared_ptr<PlaintextNTT> Scheme::loadConstVec(complex<double>* cnstVec, long n, long logp, long logq) {
+	lock_guard<mutex> lock(constVecMutex);
+	auto it = constVecCache.find(cnstVec);
+	if(it != constVecCache.end()) {
+		ConstVecEntry& entry = it->second;
+		PlaintextNTT& plain = *entry.plain;
+		if(plain.n == n && plain.logp == logp && plain.logq >= logq && equal(entry.vals.begin(), entry.vals.end(), cnstVec)) {
+			entry.lastUse = ++constVecClock;
+			return entry.plain;
+		}
+		constVecCache.erase(it);
+	}
+	shared_ptr<PlaintextNTT> plain = make_shared<PlaintextNTT>();
+	encodeNTT(*plain, cnstVec, n, logp, logq);
+	if(constVecCacheSize <= 0) return plain;
+	while(constVecCache.size() >= (size_t)constVecCacheSize) {
+		auto lru = constVecCache.begin();
+		for (auto jt = constVecCache.begin(); jt != constVecCache.end(); ++jt) {
+			if(jt->second.lastUse < lru->second.lastUse) lru = jt;
+		}
+		constVecCache.erase(lru);
+	}
+	ConstVecEntry& entry = constVecCache[cnstVec];
+	entry.vals.assign(cnstVec, cnstVec + n);
+	entry.plain = plain;
+	entry.lastUse = ++constVecClock;
+	return plain;
+}
+
+void Scheme::clearConstVecCache() {
+	lock_guard<mutex> lock(constVecMutex);
+	constVecCache.clear();
 }
 
 void Scheme::multByConstAndEqual(Ciphertext& cipher, double cnst, long logp) {
+	cipher.freeNTT();
 	ZZ q = ring.qpows[cipher.logq];
 	ZZ cnstZZ = EvaluatorUtils::scaleUpToZZ(cnst, logp);
 	ring.multByConstAndEqual(cipher.ax, cnstZZ, q);
@@ -655,6 +971,7 @@ void Scheme::multByConstAndEqual(Ciphertext& cipher, double cnst, long logp) {
 }
 
 void Scheme::multByConstAndEqual(Ciphertext& cipher, RR& cnst, long logp) {
+	cipher.freeNTT();
 	ZZ q = ring.qpows[cipher.logq];
 	ZZ cnstZZ = EvaluatorUtils::scaleUpToZZ(cnst, logp);
 	ring.multByConstAndEqual(cipher.ax, cnstZZ, q);
@@ -663,10 +980,12 @@ void Scheme::multByConstAndEqual(Ciphertext& cipher, RR& cnst, long logp) {
 }
 
 void Scheme::multByConstAndEqual(Ciphertext& cipher, complex<double> cnst, long logp) {
+	cipher.freeNTT();
 	ZZ q = ring.qpows[cipher.logq];
-	ZZ cnstZZ = EvaluatorUtils::scaleUpToZZ(cnst.real(), logp);
-	ring.multByConstAndEqual(cipher.ax, cnstZZ, q);
-	ring.multByConstAndEqual(cipher.bx, cnstZZ, q);
+	ZZ cnstr = EvaluatorUtils::scaleUpToZZ(cnst.real(), logp);
+	ZZ cnsti = EvaluatorUtils::scaleUpToZZ(cnst.imag(), logp);
+	ring.multByComplexConstAndEqual(cipher.ax, cnstr, cnsti, q);
+	ring.multByComplexConstAndEqual(cipher.bx, cnstr, cnsti, q);
 	cipher.logp += logp;
 }
 
@@ -693,6 +1012,7 @@ void Scheme::multByPolyNTT(Ciphertext& res, Ciphertext& cipher, uint64_t* rpoly,
 }
 
 void Scheme::multByPolyAndEqual(Ciphertext& cipher, ZZ* poly, long logp) {
+	cipher.freeNTT();
 	ZZ q = ring.qpows[cipher.logq];
 	long bnd = ring.maxBits(poly, N);
 	long np = ceil((cipher.logq + bnd + logN + 2)/(double)pbnd);
@@ -705,6 +1025,7 @@ void Scheme::multByPolyAndEqual(Ciphertext& cipher, ZZ* poly, long logp) {
 }
 
 void Scheme::multByPolyNTTAndEqual(Ciphertext& cipher, uint64_t* rpoly, long bnd, long logp) {
+	cipher.freeNTT();
 	ZZ q = ring.qpows[cipher.logq];
 	long np = ceil((cipher.logq + bnd + logN + 2)/(double)pbnd);
 	ring.multNTTAndEqual(cipher.ax, rpoly, np, q);
@@ -712,6 +1033,23 @@ void Scheme::multByPolyNTTAndEqual(Ciphertext& cipher, uint64_t* rpoly, long bnd
 	cipher.logp += logp;
 }
 
+/**
+ * plain holds enough primes only for ciphertexts with logq <= plain.logq.
+ */
+void Scheme::multByPoly(Ciphertext& res, Ciphertext& cipher, PlaintextNTT& plain) {
+	if(cipher.logq > plain.logq) {
+		throw invalid_argument("ciphertext modulus is larger than the plaintext was encoded for");
+	}
+	multByPolyNTT(res, cipher, plain.rx, plain.bnd, plain.logp);
+}
+
+void Scheme::multByPolyAndEqual(Ciphertext& cipher, PlaintextNTT& plain) {
+	if(cipher.logq > plain.logq) {
+		throw invalid_argument("ciphertext modulus is larger than the plaintext was encoded for");
+	}
+	multByPolyNTTAndEqual(cipher, plain.rx, plain.bnd, plain.logp);
+}
+
 //-----------------------------------------
 
 void Scheme::multByMonomial(Ciphertext& res, Ciphertext& cipher, const long degree) {
@@ -721,6 +1059,7 @@ void Scheme::multByMonomial(Ciphertext& res, Ciphertext& cipher, const long degr
 }
 
 void Scheme::multByMonomialAndEqual(Ciphertext& cipher, const long degree) {
+	cipher.freeNTT();
 	ring.multByMonomialAndEqual(cipher.ax, degree);
 	ring.multByMonomialAndEqual(cipher.bx, degree);
 }
@@ -735,12 +1074,14 @@ void Scheme::leftShift(Ciphertext& res, Ciphertext& cipher, long bits) {
 }
 
 void Scheme::leftShiftAndEqual(Ciphertext& cipher, long bits) {
+	cipher.freeNTT();
 	ZZ q = ring.qpows[cipher.logq];
 	ring.leftShiftAndEqual(cipher.ax, bits, q);
 	ring.leftShiftAndEqual(cipher.bx, bits, q);
 }
 
 void Scheme::doubleAndEqual(Ciphertext& cipher) {
+	cipher.freeNTT();
 	ZZ q = ring.qpows[cipher.logq];
 	ring.doubleAndEqual(cipher.ax, q);
 	ring.doubleAndEqual(cipher.bx, q);
@@ -754,6 +1095,7 @@ void Scheme::divByPo2(Ciphertext& res, Ciphertext& cipher, long bits) {
 }
 
 void Scheme::divByPo2AndEqual(Ciphertext& cipher, long bits) {
+	cipher.freeNTT();
 	ring.rightShiftAndEqual(cipher.ax, bits);
 	ring.rightShiftAndEqual(cipher.bx, bits);
 	cipher.logq -= bits;
@@ -779,6 +1121,7 @@ void Scheme::reScaleTo(Ciphertext& res, Ciphertext& cipher, long logq) {
 }
 
 void Scheme::reScaleByAndEqual(Ciphertext& cipher, long dlogq) {
+	cipher.freeNTT();
 	ring.rightShiftAndEqual(cipher.ax, dlogq);
 	ring.rightShiftAndEqual(cipher.bx, dlogq);
 	cipher.logq -= dlogq;
@@ -786,6 +1129,7 @@ void Scheme::reScaleByAndEqual(Ciphertext& cipher, long dlogq) {
 }
 
 void Scheme::reScaleToAndEqual(Ciphertext& cipher, long logq) {
+	cipher.freeNTT();
 	long dlogq = cipher.logq - logq;
 	ring.rightShiftAndEqual(cipher.ax, dlogq);
 	ring.rightShiftAndEqual(cipher.bx, dlogq);
@@ -802,6 +1146,7 @@ void Scheme::modDownBy(Ciphertext& res, Ciphertext& cipher, long dlogq) {
 }
 
 void Scheme::modDownByAndEqual(Ciphertext& cipher, long dlogq) {
+	cipher.freeNTT();
 	ZZ q = ring.qpows[cipher.logq - dlogq];
 	ring.modAndEqual(cipher.ax, q);
 	ring.modAndEqual(cipher.bx, q);
@@ -817,6 +1162,7 @@ void Scheme::modDownTo(Ciphertext& res, Ciphertext& cipher, long logq) {
 }
 
 void Scheme::modDownToAndEqual(Ciphertext& cipher, long logq) {
+	cipher.freeNTT();
 	ZZ q = ring.qpows[logq];
 	cipher.logq = logq;
 	ring.modAndEqual(cipher.ax, q);
@@ -839,7 +1185,7 @@ void Scheme::leftRotateFast(Ciphertext& res, Ciphertext& cipher, long r) {
 	ring.leftRotate(bxrot, cipher.bx, r);
 	ring.leftRotate(axrot, cipher.ax, r);
 
-	Key* key = isSerialized ? SerializationUtils::readKey(serLeftRotKeyMap.at(r)) : leftRotKeyMap.at(r);
+	Key* key = getLeftRotKey(r);
 	res.copyParams(cipher);
 
 	long np = ceil((cipher.logq + logQQ + logN + 2)/(double)pbnd);
@@ -857,6 +1203,7 @@ void Scheme::leftRotateFast(Ciphertext& res, Ciphertext& cipher, long r) {
 }
 
 void Scheme::leftRotateFastAndEqual(Ciphertext& cipher, long r) {
+	cipher.freeNTT();
 	ZZ q = ring.qpows[cipher.logq];
 	ZZ qQ = ring.qpows[cipher.logq + logQ];
 
@@ -865,7 +1212,7 @@ void Scheme::leftRotateFastAndEqual(Ciphertext& cipher, long r) {
 
 	ring.leftRotate(bxrot, cipher.bx, r);
 	ring.leftRotate(axrot, cipher.ax, r);
-	Key* key = isSerialized ? SerializationUtils::readKey(serLeftRotKeyMap.at(r)) : leftRotKeyMap.at(r);
+	Key* key = getLeftRotKey(r);
 	long np = ceil((cipher.logq + logQQ + logN + 2)/(double)pbnd);
 	uint64_t* rarot = new uint64_t[np << logN];
 	ring.CRT(rarot, axrot, np);
@@ -892,6 +1239,117 @@ void Scheme::rightRotateFastAndEqual(Ciphertext& cipher, long r) {
 	leftRotateFastAndEqual(cipher, rr);
 }
 
+/**
+ * res[j] = cipher rotated left by rvec[j]. The CRT of ax is computed once and
+ * permuted in NTT form for every rotation; res must not contain cipher.
+ */
+void Scheme::leftRotateFastHoisted(Ciphertext* res, Ciphertext& cipher, long* rvec, long count) {
+	ZZ q = ring.qpows[cipher.logq];
+	ZZ qQ = ring.qpows[cipher.logq + logQ];
+
+	long np = ceil((cipher.logq + logQQ + logN + 2)/(double)pbnd);
+	uint64_t* ra = new uint64_t[np << logN];
+	ring.CRT(ra, cipher.ax, np);
+
+	NTL_EXEC_RANGE(count, first, last);
+	uint64_t* rarot = new uint64_t[np << logN];
+	ZZ* bxrot = new ZZ[N];
+	for (long j = first; j < last; ++j) {
+		if(rvec[j] == 0) {
+			res[j].copy(cipher);
+			continue;
+		}
+		Key* key = getLeftRotKey(rvec[j]);
+		res[j].copyParams(cipher);
+		ring.leftRotateNTT(rarot, ra, rvec[j], np);
+		ring.multDNTT(res[j].ax, rarot, key->rax, np, qQ);
+		ring.multDNTT(res[j].bx, rarot, key->rbx, np, qQ);
+		ring.rightShiftAndEqual(res[j].ax, logQ);
+		ring.rightShiftAndEqual(res[j].bx, logQ);
+		ring.leftRotate(bxrot, cipher.bx, rvec[j]);
+		ring.addAndEqual(res[j].bx, bxrot, q);
+	}
+	delete[] rarot;
+	delete[] bxrot;
+	NTL_EXEC_RANGE_END;
+
+	delete[] ra;
+}
+
+void Scheme::leftRotateByKeys(Ciphertext& res, Ciphertext& cipher, long r) {
+	vector<long> steps = leftRotKeySteps(r);
+	if(steps.empty()) {
+		res.copy(cipher);
+		return;
+	}
+	leftRotateFast(res, cipher, steps[0]);
+	for (size_t i = 1; i < steps.size(); ++i) {
+		leftRotateFastAndEqual(res, steps[i]);
+	}
+}
+
+void Scheme::sumSlots(Ciphertext& res, Ciphertext& cipher, long blockSize, long count, bool conjFold) {
+	res.copy(cipher);
+	sumSlotsAndEqual(res, blockSize, count, conjFold);
+}
+
+/**
+ * Slot i becomes the sum of slots i + t * blockSize for t < count.
+ * With conjFold the real part of that sum is kept, in every slot of a real-valued result.
+ */
+void Scheme::sumSlotsAndEqual(Ciphertext& cipher, long blockSize, long count, bool conjFold) {
+	rotateAndSumAndEqual(cipher, blockSize, count);
+	if(conjFold) {
+		Ciphertext cconj;
+		conjugate(cconj, cipher);
+		addAndEqual(cipher, cconj);
+		divByPo2AndEqual(cipher, 1);
+	}
+}
+
+void Scheme::replicateSlots(Ciphertext& res, Ciphertext& cipher, long blockSize, long count) {
+	res.copy(cipher);
+	replicateSlotsAndEqual(res, blockSize, count);
+}
+
+/**
+ * Slot i becomes the sum of slots i - t * blockSize for t < count,
+ * which copies a block of blockSize slots count times if the other slots are zero.
+ */
+void Scheme::replicateSlotsAndEqual(Ciphertext& cipher, long blockSize, long count) {
+	rotateAndSumAndEqual(cipher, -blockSize, count, cipher.n);
+}
+
+/**
+ * cipher = sum_{t < count} rot(cipher, t * stride), with one rotation per bit of count
+ * and one more per set bit below the top one. Rotations are taken modulo period,
+ * which may be the number of slots when they repeat with that period.
+ */
+void Scheme::rotateAndSumAndEqual(Ciphertext& cipher, long stride, long count, long period) {
+	stride = ((stride % period) + period) % period;
+	Ciphertext res, rot;
+	bool isEmpty = true;
+	long offset = 0;
+	// cipher holds the sum of the first len terms, res the sum of the first offset terms
+	for (long len = 1; len <= count; len <<= 1) {
+		if(count & len) {
+			if(isEmpty) {
+				res.copy(cipher);
+				isEmpty = false;
+			} else {
+				leftRotateByKeys(rot, cipher, (offset * stride) % period);
+				addAndEqual(res, rot);
+			}
+			offset += len;
+		}
+		if((len << 1) <= count) {
+			leftRotateByKeys(rot, cipher, (len * stride) % period);
+			addAndEqual(cipher, rot);
+		}
+	}
+	cipher.copy(res);
+}
+
 void Scheme::conjugate(Ciphertext& res, Ciphertext& cipher) {
 	ZZ q = ring.qpows[cipher.logq];
 	ZZ qQ = ring.qpows[cipher.logq + logQ];
@@ -902,7 +1360,7 @@ void Scheme::conjugate(Ciphertext& res, Ciphertext& cipher) {
 	ring.conjugate(bxconj, cipher.bx);
 	ring.conjugate(axconj, cipher.ax);
 
-	Key* key = isSerialized ? SerializationUtils::readKey(serKeyMap.at(CONJUGATION)) : keyMap.at(CONJUGATION);
+	Key* key = getKey(CONJUGATION);
 	res.copyParams(cipher);
 	long np = ceil((cipher.logq + logQQ + logN + 2)/(double)pbnd);
 	uint64_t* raconj = new uint64_t[np << logN];
@@ -920,6 +1378,7 @@ void Scheme::conjugate(Ciphertext& res, Ciphertext& cipher) {
 }
 
 void Scheme::conjugateAndEqual(Ciphertext& cipher) {
+	cipher.freeNTT();
 	ZZ q = ring.qpows[cipher.logq];
 	ZZ qQ = ring.qpows[cipher.logq + logQ];
 
@@ -929,7 +1388,7 @@ void Scheme::conjugateAndEqual(Ciphertext& cipher) {
 	ring.conjugate(bxconj, cipher.bx);
 	ring.conjugate(axconj, cipher.ax);
 
-	Key* key = isSerialized ? SerializationUtils::readKey(serKeyMap.at(CONJUGATION)) : keyMap.at(CONJUGATION);
+	Key* key = getKey(CONJUGATION);
 
 	long np = ceil((cipher.logq + logQQ + logN + 2)/(double)pbnd);
 	uint64_t* raconj = new uint64_t[np << logN];
@@ -949,100 +1408,467 @@ void Scheme::conjugateAndEqual(Ciphertext& cipher) {
 
 
 //----------------------------------------------------------------------------------
-//   BOOTSTRAPPING
+//   DEFERRED RELINEARIZATION
 //----------------------------------------------------------------------------------
 
 
-void Scheme::normalizeAndEqual(Ciphertext& cipher) {
-	ZZ q = ring.qpows[cipher.logq];
+void Scheme::multNoRelin(CiphertextTensor& res, Ciphertext& cipher1, Ciphertext& cipher2) {
+	ZZ q = ring.qpows[cipher1.logq];
 
-	for (long i = 0; i < N; ++i) {
-		if(NumBits(cipher.ax[i]) == cipher.logq) cipher.ax[i] -= q;
-		if(NumBits(cipher.bx[i]) == cipher.logq) cipher.bx[i] -= q;
-	}
+	long np = ceil((2 + cipher1.logq + cipher2.logq + logN + 2)/(double)pbnd);
+
+	uint64_t* ra1, *rb1, *ra2, *rb2;
+	loadNTT(ra1, rb1, cipher1, np);
+	loadNTT(ra2, rb2, cipher2, np);
+
+	ring.multDNTT(res.ax, ra1, ra2, np, q);
+	ring.multDNTT(res.bx, rb1, rb2, np, q);
+
+	uint64_t* rab1 = (ra1 == cipher1.rax) ? new uint64_t[np << logN] : ra1;
+	uint64_t* rab2 = (ra2 == cipher2.rax) ? new uint64_t[np << logN] : ra2;
+	ring.addNTT(rab1, ra1, rb1, np);
+	ring.addNTT(rab2, ra2, rb2, np);
+	ring.multDNTT(res.abx, rab1, rab2, np, q);
+
+	if(rab1 != ra1) delete[] rab1;
+	if(rab2 != ra2) delete[] rab2;
+	unloadNTT(ra1, rb1, cipher1);
+	unloadNTT(ra2, rb2, cipher2);
+
+	ring.subAndEqual(res.abx, res.ax, q);
+	ring.subAndEqual(res.abx, res.bx, q);
+
+	res.logp = cipher1.logp + cipher2.logp;
+	res.logq = cipher1.logq;
+	res.n = cipher1.n;
 }
 
-void Scheme::coeffToSlotAndEqual(Ciphertext& cipher) {
-	long slots = cipher.n;
-	long logSlots = log2(slots);
-	long logk = logSlots / 2;
-	long k = 1 << logk;
+void Scheme::add(CiphertextTensor& res, CiphertextTensor& tensor1, CiphertextTensor& tensor2) {
+	ZZ q = ring.qpows[tensor1.logq];
+	res.copyParams(tensor1);
+	ring.add(res.ax, tensor1.ax, tensor2.ax, q);
+	ring.add(res.bx, tensor1.bx, tensor2.bx, q);
+	ring.add(res.abx, tensor1.abx, tensor2.abx, q);
+}
 
-	Ciphertext* rotvec = new Ciphertext[k];
-	rotvec[0].copy(cipher);
+void Scheme::addAndEqual(CiphertextTensor& tensor1, CiphertextTensor& tensor2) {
+	ZZ q = ring.qpows[tensor1.logq];
+	ring.addAndEqual(tensor1.ax, tensor2.ax, q);
+	ring.addAndEqual(tensor1.bx, tensor2.bx, q);
+	ring.addAndEqual(tensor1.abx, tensor2.abx, q);
+}
 
-	NTL_EXEC_RANGE(k - 1, first, last);
-	for (long j = first; j < last; ++j) {
-		leftRotateFast(rotvec[j+1], rotvec[0], j + 1);
+void Scheme::relinearize(Ciphertext& res, CiphertextTensor& tensor) {
+	res.freeNTT();
+	res.logp = tensor.logp;
+	res.logq = tensor.logq;
+	res.n = tensor.n;
+
+	ZZ q = ring.qpows[tensor.logq];
+	ZZ qQ = ring.qpows[tensor.logq + logQ];
+
+	Key* key = getKey(MULTIPLICATION);
+
+	long np = ceil((tensor.logq + logQQ + logN + 2)/(double)pbnd);
+	uint64_t* raa = new uint64_t[np << logN];
+	ring.CRT(raa, tensor.ax, np);
+	ring.multDNTT(res.ax, raa, key->rax, np, qQ);
+	ring.multDNTT(res.bx, raa, key->rbx, np, qQ);
+	ring.rightShiftAndEqual(res.ax, logQ);
+	ring.rightShiftAndEqual(res.bx, logQ);
+
+	ring.addAndEqual(res.ax, tensor.abx, q);
+	ring.addAndEqual(res.bx, tensor.bx, q);
+
+	delete[] raa;
+}
+
+
+void Scheme::innerProduct(Ciphertext& res, Ciphertext* cipher1, Ciphertext* cipher2, long count, long logp) {
+	if(count <= 0) {
+		throw invalid_argument("innerProduct needs at least one pair");
 	}
-	NTL_EXEC_RANGE_END;
+	long logq = cipher1[0].logq;
+	for (long i = 0; i < count; ++i) {
+		if(cipher1[i].logq != logq || cipher2[i].logq != logq) {
+			throw invalid_argument("innerProduct needs all ciphertexts at the same level");
+		}
+		if(cipher1[i].logp != cipher1[0].logp || cipher2[i].logp != cipher2[0].logp) {
+			throw invalid_argument("innerProduct needs the same logp across the pairs");
+		}
+	}
+	ZZ q = ring.qpows[logq];
 
-	BootContext* bootContext = ring.bootContextMap.at(logSlots);
+	long logcount = ceil(log2((double)count));
+	long np = ceil((2 + 2 * logq + logN + 2 + logcount)/(double)pbnd);
 
-	Ciphertext* tmpvec = new Ciphertext[k];
+	// cached NTT forms are built here, since one ciphertext may appear in several chunks below
+	for (long i = 0; i < count; ++i) {
+		uint64_t* ra, *rb;
+		if(cipher1[i].keepNTT) loadNTT(ra, rb, cipher1[i], np);
+		if(cipher2[i].keepNTT) loadNTT(ra, rb, cipher2[i], np);
+	}
 
-	NTL_EXEC_RANGE(k, first, last);
-	for (long j = first; j < last; ++j) {
-		multByPolyNTT(tmpvec[j], rotvec[j], bootContext->rpvec[j], bootContext->bndvec[j], bootContext->logp);
+	// with few primes the per-prime loops cannot use all threads, so split the pairs instead
+	long nchunks = (np < AvailableThreads()) ? min(count, AvailableThreads()) : 1;
+	uint64_t** raxax = new uint64_t*[nchunks];
+	uint64_t** rbxbx = new uint64_t*[nchunks];
+	uint64_t** rabab = new uint64_t*[nchunks];
+
+	NTL_EXEC_RANGE(nchunks, first, last);
+	for (long c = first; c < last; ++c) {
+		raxax[c] = new uint64_t[np << logN];
+		rbxbx[c] = new uint64_t[np << logN];
+		rabab[c] = new uint64_t[np << logN];
+		uint64_t* rab1 = new uint64_t[np << logN];
+		uint64_t* rab2 = new uint64_t[np << logN];
+		uint64_t* rtmp = new uint64_t[np << logN];
+		long begin = c * count / nchunks;
+		long end = (c + 1) * count / nchunks;
+		for (long i = begin; i < end; ++i) {
+			uint64_t* ra1, *rb1, *ra2, *rb2;
+			loadNTT(ra1, rb1, cipher1[i], np);
+			loadNTT(ra2, rb2, cipher2[i], np);
+			ring.addNTT(rab1, ra1, rb1, np);
+			ring.addNTT(rab2, ra2, rb2, np);
+			if(i == begin) {
+				ring.pointwiseMult(raxax[c], ra1, ra2, np);
+				ring.pointwiseMult(rbxbx[c], rb1, rb2, np);
+				ring.pointwiseMult(rabab[c], rab1, rab2, np);
+			} else {
+				ring.pointwiseMult(rtmp, ra1, ra2, np);
+				ring.addNTTAndEqual(raxax[c], rtmp, np);
+				ring.pointwiseMult(rtmp, rb1, rb2, np);
+				ring.addNTTAndEqual(rbxbx[c], rtmp, np);
+				ring.pointwiseMult(rtmp, rab1, rab2, np);
+				ring.addNTTAndEqual(rabab[c], rtmp, np);
+			}
+			unloadNTT(ra1, rb1, cipher1[i]);
+			unloadNTT(ra2, rb2, cipher2[i]);
+		}
+		delete[] rab1;
+		delete[] rab2;
+		delete[] rtmp;
 	}
 	NTL_EXEC_RANGE_END;
 
-	for (long j = 1; j < k; ++j) {
-		addAndEqual(tmpvec[0], tmpvec[j]);
+	for (long c = 1; c < nchunks; ++c) {
+		ring.addNTTAndEqual(raxax[0], raxax[c], np);
+		ring.addNTTAndEqual(rbxbx[0], rbxbx[c], np);
+		ring.addNTTAndEqual(rabab[0], rabab[c], np);
 	}
 
-	cipher.copy(tmpvec[0]);
-	for (long ki = k; ki < slots; ki += k) {
-		NTL_EXEC_RANGE(k, first, last);
-		for (long j = first; j < last; ++j) {
-			multByPolyNTT(tmpvec[j], rotvec[j], bootContext->rpvec[j + ki], bootContext->bndvec[j + ki], bootContext->logp);
-		}
-		NTL_EXEC_RANGE_END;
-		for (long j = 1; j < k; ++j) {
-			addAndEqual(tmpvec[0], tmpvec[j]);
+	CiphertextTensor tensor(cipher1[0].logp + cipher2[0].logp, logq, cipher1[0].n);
+	ring.reconstructNTT(tensor.ax, raxax[0], np, q);
+	ring.reconstructNTT(tensor.bx, rbxbx[0], np, q);
+	ring.reconstructNTT(tensor.abx, rabab[0], np, q);
+	ring.subAndEqual(tensor.abx, tensor.ax, q);
+	ring.subAndEqual(tensor.abx, tensor.bx, q);
+
+	for (long c = 0; c < nchunks; ++c) {
+		delete[] raxax[c];
+		delete[] rbxbx[c];
+		delete[] rabab[c];
+	}
+	delete[] raxax;
+	delete[] rbxbx;
+	delete[] rabab;
+
+	relinearize(res, tensor);
+	reScaleByAndEqual(res, logp);
+}
+
+
+//----------------------------------------------------------------------------------
+//   NTT-RESIDENT OPERATIONS
+//----------------------------------------------------------------------------------
+
+
+static double addBnd(double logbnd1, double logbnd2) {
+	double m = max(logbnd1, logbnd2);
+	return m + log2(1 + pow(2.0, min(logbnd1, logbnd2) - m));
+}
+
+static bool fitsNTT(double logbnd, long np) {
+	return logbnd + 1 <= np * pbnd;
+}
+
+void Scheme::toNTT(CiphertextNTT& res, Ciphertext& cipher, long np) {
+	res.resize(np);
+	res.logp = cipher.logp;
+	res.logq = cipher.logq;
+	res.n = cipher.n;
+	res.logbnd = max(ring.maxBits(cipher.ax, N), ring.maxBits(cipher.bx, N));
+	ring.CRT(res.rax, cipher.ax, np);
+	ring.CRT(res.rbx, cipher.bx, np);
+}
+
+void Scheme::fromNTT(Ciphertext& res, CiphertextNTT& cipher) {
+	ZZ q = ring.qpows[cipher.logq];
+	res.freeNTT();
+	res.logp = cipher.logp;
+	res.logq = cipher.logq;
+	res.n = cipher.n;
+	ring.reconstructNTT(res.ax, cipher.rax, cipher.np, q);
+	ring.reconstructNTT(res.bx, cipher.rbx, cipher.np, q);
+}
+
+void Scheme::reduceNTTAndEqual(CiphertextNTT& cipher) {
+	ZZ q = ring.qpows[cipher.logq];
+	ZZ* tmp = new ZZ[N];
+	ring.reconstructNTT(tmp, cipher.rax, cipher.np, q);
+	ring.CRT(cipher.rax, tmp, cipher.np);
+	ring.reconstructNTT(tmp, cipher.rbx, cipher.np, q);
+	ring.CRT(cipher.rbx, tmp, cipher.np);
+	cipher.logbnd = cipher.logq;
+	delete[] tmp;
+}
+
+/**
+ * Rebuilds the coefficients modulo q over np primes, np >= cipher.np.
+ */
+void Scheme::extendNTTAndEqual(CiphertextNTT& cipher, long np) {
+	ZZ q = ring.qpows[cipher.logq];
+	ZZ* ax = new ZZ[N];
+	ZZ* bx = new ZZ[N];
+	ring.reconstructNTT(ax, cipher.rax, cipher.np, q);
+	ring.reconstructNTT(bx, cipher.rbx, cipher.np, q);
+	cipher.resize(np);
+	ring.CRT(cipher.rax, ax, np);
+	ring.CRT(cipher.rbx, bx, np);
+	cipher.logbnd = cipher.logq;
+	delete[] ax;
+	delete[] bx;
+}
+
+/**
+ * Extends the operand with fewer primes so both have the same np.
+ * Operands at different levels cannot be combined.
+ */
+void Scheme::matchNTT(CiphertextNTT& cipher1, CiphertextNTT& cipher2) {
+	if(cipher1.logq != cipher2.logq) {
+		throw invalid_argument("ciphertexts are at different levels");
+	}
+	if(cipher1.np < cipher2.np) {
+		extendNTTAndEqual(cipher1, cipher2.np);
+	} else if(cipher2.np < cipher1.np) {
+		extendNTTAndEqual(cipher2, cipher1.np);
+	}
+}
+
+/**
+ * Brings cipher1 and cipher2 to the same np with room for their sum,
+ * reducing them modulo q and then adding primes if reducing is not enough.
+ */
+void Scheme::fitAddNTT(CiphertextNTT& cipher1, CiphertextNTT& cipher2) {
+	matchNTT(cipher1, cipher2);
+	if(fitsNTT(addBnd(cipher1.logbnd, cipher2.logbnd), cipher1.np)) return;
+	reduceNTTAndEqual(cipher1);
+	reduceNTTAndEqual(cipher2);
+	double logbnd = addBnd(cipher1.logbnd, cipher2.logbnd);
+	if(!fitsNTT(logbnd, cipher1.np)) {
+		long np = ceil((logbnd + 1)/(double)pbnd);
+		extendNTTAndEqual(cipher1, np);
+		extendNTTAndEqual(cipher2, np);
+	}
+}
+
+void Scheme::add(CiphertextNTT& res, CiphertextNTT& cipher1, CiphertextNTT& cipher2) {
+	fitAddNTT(cipher1, cipher2);
+	double logbnd = addBnd(cipher1.logbnd, cipher2.logbnd);
+	res.copyParams(cipher1);
+	ring.addNTT(res.rax, cipher1.rax, cipher2.rax, res.np);
+	ring.addNTT(res.rbx, cipher1.rbx, cipher2.rbx, res.np);
+	res.logbnd = logbnd;
+}
+
+void Scheme::addAndEqual(CiphertextNTT& cipher1, CiphertextNTT& cipher2) {
+	fitAddNTT(cipher1, cipher2);
+	ring.addNTTAndEqual(cipher1.rax, cipher2.rax, cipher1.np);
+	ring.addNTTAndEqual(cipher1.rbx, cipher2.rbx, cipher1.np);
+	cipher1.logbnd = addBnd(cipher1.logbnd, cipher2.logbnd);
+}
+
+void Scheme::sub(CiphertextNTT& res, CiphertextNTT& cipher1, CiphertextNTT& cipher2) {
+	fitAddNTT(cipher1, cipher2);
+	double logbnd = addBnd(cipher1.logbnd, cipher2.logbnd);
+	res.copyParams(cipher1);
+	ring.subNTT(res.rax, cipher1.rax, cipher2.rax, res.np);
+	ring.subNTT(res.rbx, cipher1.rbx, cipher2.rbx, res.np);
+	res.logbnd = logbnd;
+}
+
+void Scheme::subAndEqual(CiphertextNTT& cipher1, CiphertextNTT& cipher2) {
+	fitAddNTT(cipher1, cipher2);
+	ring.subNTTAndEqual(cipher1.rax, cipher2.rax, cipher1.np);
+	ring.subNTTAndEqual(cipher1.rbx, cipher2.rbx, cipher1.np);
+	cipher1.logbnd = addBnd(cipher1.logbnd, cipher2.logbnd);
+}
+
+void Scheme::multByPolyNTT(CiphertextNTT& res, CiphertextNTT& cipher, uint64_t* rpoly, long bnd, long logp) {
+	res.copy(cipher);
+	multByPolyNTTAndEqual(res, rpoly, bnd, logp);
+}
+
+void Scheme::multByPolyNTTAndEqual(CiphertextNTT& cipher, uint64_t* rpoly, long bnd, long logp) {
+	if(!fitsNTT(cipher.logbnd + bnd + logN, cipher.np)) {
+		reduceNTTAndEqual(cipher);
+		// rpoly has only cipher.np primes, so the ciphertext cannot be extended here
+		if(!fitsNTT(cipher.logbnd + bnd + logN, cipher.np)) {
+			throw invalid_argument("product does not fit in the primes of the ciphertext");
 		}
-		leftRotateFastAndEqual(tmpvec[0], ki);
-		addAndEqual(cipher, tmpvec[0]);
 	}
-	reScaleByAndEqual(cipher, bootContext->logp);
-	delete[] rotvec;
-	delete[] tmpvec;
+	ring.pointwiseMultAndEqual(cipher.rax, rpoly, cipher.np);
+	ring.pointwiseMultAndEqual(cipher.rbx, rpoly, cipher.np);
+	cipher.logbnd += bnd + logN;
+	cipher.logp += logp;
 }
 
-void Scheme::slotToCoeffAndEqual(Ciphertext& cipher) {
+void Scheme::multByPoly(CiphertextNTT& res, CiphertextNTT& cipher, PlaintextNTT& plain) {
+	if(cipher.np > plain.np) {
+		throw invalid_argument("ciphertext has more primes than the plaintext");
+	}
+	multByPolyNTT(res, cipher, plain.rx, plain.bnd, plain.logp);
+}
+
+void Scheme::multByPolyAndEqual(CiphertextNTT& cipher, PlaintextNTT& plain) {
+	if(cipher.np > plain.np) {
+		throw invalid_argument("ciphertext has more primes than the plaintext");
+	}
+	multByPolyNTTAndEqual(cipher, plain.rx, plain.bnd, plain.logp);
+}
+
+void Scheme::keySwitchNTT(CiphertextNTT& res, CiphertextNTT& cipher, uint64_t* rarot, uint64_t* rbrot, Key* key) {
+	ZZ q = ring.qpows[cipher.logq];
+	ZZ qQ = ring.qpows[cipher.logq + logQ];
+
+	ZZ* ax = new ZZ[N];
+	ZZ* bx = new ZZ[N];
+	ring.reconstructNTT(ax, rarot, cipher.np, q);
+
+	long np = ceil((cipher.logq + logQQ + logN + 2)/(double)pbnd);
+	uint64_t* rarotQ = new uint64_t[np << logN];
+	ring.CRT(rarotQ, ax, np);
+	ring.multDNTT(ax, rarotQ, key->rax, np, qQ);
+	ring.multDNTT(bx, rarotQ, key->rbx, np, qQ);
+	ring.rightShiftAndEqual(ax, logQ);
+	ring.rightShiftAndEqual(bx, logQ);
+
+	double logbnd = addBnd(cipher.logbnd, cipher.logq);
+	res.copyParams(cipher);
+	ring.CRT(res.rax, ax, res.np);
+	ring.CRT(rarot, bx, res.np);
+	ring.addNTT(res.rbx, rbrot, rarot, res.np);
+	res.logbnd = logbnd;
+
+	delete[] ax;
+	delete[] bx;
+	delete[] rarotQ;
+}
+
+void Scheme::leftRotateFast(CiphertextNTT& res, CiphertextNTT& cipher, long r) {
+	uint64_t* rarot = new uint64_t[cipher.np << logN];
+	uint64_t* rbrot = new uint64_t[cipher.np << logN];
+	ring.leftRotateNTT(rarot, cipher.rax, r, cipher.np);
+	ring.leftRotateNTT(rbrot, cipher.rbx, r, cipher.np);
+
+	Key* key = getLeftRotKey(r);
+	keySwitchNTT(res, cipher, rarot, rbrot, key);
+
+	delete[] rarot;
+	delete[] rbrot;
+}
+
+void Scheme::leftRotateFastAndEqual(CiphertextNTT& cipher, long r) {
+	leftRotateFast(cipher, cipher, r);
+}
+
+void Scheme::conjugate(CiphertextNTT& res, CiphertextNTT& cipher) {
+	uint64_t* raconj = new uint64_t[cipher.np << logN];
+	uint64_t* rbconj = new uint64_t[cipher.np << logN];
+	ring.conjugateNTT(raconj, cipher.rax, cipher.np);
+	ring.conjugateNTT(rbconj, cipher.rbx, cipher.np);
+
+	Key* key = getKey(CONJUGATION);
+	keySwitchNTT(res, cipher, raconj, rbconj, key);
+
+	delete[] raconj;
+	delete[] rbconj;
+}
+
+void Scheme::conjugateAndEqual(CiphertextNTT& cipher) {
+	conjugate(cipher, cipher);
+}
+
+
+//----------------------------------------------------------------------------------
+//   BOOTSTRAPPING
+//----------------------------------------------------------------------------------
+
+
+void Scheme::normalizeAndEqual(Ciphertext& cipher) {
+	cipher.freeNTT();
+	ZZ q = ring.qpows[cipher.logq];
+
+	for (long i = 0; i < N; ++i) {
+		if(NumBits(cipher.ax[i]) == cipher.logq) cipher.ax[i] -= q;
+		if(NumBits(cipher.bx[i]) == cipher.logq) cipher.bx[i] -= q;
+	}
+}
+
+void Scheme::linearTransformAndEqual(Ciphertext& cipher, uint64_t** rpvec, long* bndvec, long logp) {
 	long slots = cipher.n;
 	long logSlots = log2(slots);
 	long logk = logSlots / 2;
 	long k = 1 << logk;
 
 	Ciphertext* rotvec = new Ciphertext[k];
-	rotvec[0].copy(cipher);
-
-	NTL_EXEC_RANGE(k-1, first, last);
-	for (long j = first; j < last; ++j) {
-		leftRotateFast(rotvec[j + 1], rotvec[0], j + 1);
+	long* rvec = new long[k];
+	for (long j = 0; j < k; ++j) {
+		rvec[j] = j;
 	}
-	NTL_EXEC_RANGE_END;
-
-	BootContext* bootContext = ring.bootContextMap.at(logSlots);
-
-	Ciphertext* tmpvec = new Ciphertext[k];
-
-	NTL_EXEC_RANGE(k, first, last);
-	for (long j = first; j < last; ++j) {
-		multByPolyNTT(tmpvec[j], rotvec[j], bootContext->rpvecInv[j], bootContext->bndvecInv[j], bootContext->logp);
+	leftRotateFastHoisted(rotvec, cipher, rvec, k);
+	delete[] rvec;
+
+	// the diagonals are kept over the primes chosen in Ring::addBootContext
+	long bnd = 0;
+	long npmin = nprimes;
+	for (long i = 0; i < slots; ++i) {
+		bnd = max(bnd, bndvec[i]);
+		npmin = min(npmin, (long)ceil((bndvec[i] + logQ + 2 * logN + 2)/(double)pbnd));
 	}
-	NTL_EXEC_RANGE_END;
+	long np = ceil((cipher.logq + 1 + bnd + logN + logk + 2)/(double)pbnd);
 
-	for (long j = 1; j < k; ++j) {
-		addAndEqual(tmpvec[0], tmpvec[j]);
-	}
-	cipher.copy(tmpvec[0]);
+	if(np <= npmin) {
+		CiphertextNTT* rrotvec = new CiphertextNTT[k];
+		for (long j = 0; j < k; ++j) {
+			toNTT(rrotvec[j], rotvec[j], np);
+		}
+		delete[] rotvec;
+
+		CiphertextNTT racc, rtmp;
+		Ciphertext tmp;
+		for (long ki = 0; ki < slots; ki += k) {
+			multByPolyNTT(racc, rrotvec[0], rpvec[ki], bndvec[ki], logp);
+			for (long j = 1; j < k; ++j) {
+				multByPolyNTT(rtmp, rrotvec[j], rpvec[j + ki], bndvec[j + ki], logp);
+				addAndEqual(racc, rtmp);
+			}
+			if(ki == 0) {
+				fromNTT(cipher, racc);
+			} else {
+				fromNTT(tmp, racc);
+				leftRotateFastAndEqual(tmp, ki);
+				addAndEqual(cipher, tmp);
+			}
+		}
+		delete[] rrotvec;
+	} else {
+		Ciphertext* tmpvec = new Ciphertext[k];
 
-	for (long ki = k; ki < slots; ki+=k) {
 		NTL_EXEC_RANGE(k, first, last);
 		for (long j = first; j < last; ++j) {
-			multByPolyNTT(tmpvec[j], rotvec[j], bootContext->rpvecInv[j + ki], bootContext->bndvecInv[j + ki], bootContext->logp);
+			multByPolyNTT(tmpvec[j], rotvec[j], rpvec[j], bndvec[j], logp);
 		}
 		NTL_EXEC_RANGE_END;
 
@@ -1050,12 +1876,35 @@ void Scheme::slotToCoeffAndEqual(Ciphertext& cipher) {
 			addAndEqual(tmpvec[0], tmpvec[j]);
 		}
 
-		leftRotateFastAndEqual(tmpvec[0], ki);
-		addAndEqual(cipher, tmpvec[0]);
+		cipher.copy(tmpvec[0]);
+		for (long ki = k; ki < slots; ki += k) {
+			NTL_EXEC_RANGE(k, first, last);
+			for (long j = first; j < last; ++j) {
+				multByPolyNTT(tmpvec[j], rotvec[j], rpvec[j + ki], bndvec[j + ki], logp);
+			}
+			NTL_EXEC_RANGE_END;
+			for (long j = 1; j < k; ++j) {
+				addAndEqual(tmpvec[0], tmpvec[j]);
+			}
+			leftRotateFastAndEqual(tmpvec[0], ki);
+			addAndEqual(cipher, tmpvec[0]);
+		}
+		delete[] rotvec;
+		delete[] tmpvec;
 	}
-	reScaleByAndEqual(cipher, bootContext->logp);
-	delete[] rotvec;
-	delete[] tmpvec;
+	reScaleByAndEqual(cipher, logp);
+}
+
+void Scheme::coeffToSlotAndEqual(Ciphertext& cipher) {
+	long logSlots = log2(cipher.n);
+	BootContext* bootContext = ring.bootContextMap.at(logSlots);
+	linearTransformAndEqual(cipher, bootContext->rpvec, bootContext->bndvec, bootContext->logp);
+}
+
+void Scheme::slotToCoeffAndEqual(Ciphertext& cipher) {
+	long logSlots = log2(cipher.n);
+	BootContext* bootContext = ring.bootContextMap.at(logSlots);
+	linearTransformAndEqual(cipher, bootContext->rpvecInv, bootContext->bndvecInv, bootContext->logp);
 }
 
 void Scheme::exp2piAndEqual(Ciphertext& cipher, long logp) {
@@ -1169,7 +2018,6 @@ void Scheme::evalExpAndEqual(Ciphertext& cipher, long logT, long logI) {
 }
 
 void Scheme::bootstrapAndEqual(Ciphertext& cipher, long logq, long logQ, long logT, long logI) {
-	long logSlots = log2(cipher.n);
 	long logp = cipher.logp;
 
 	modDownToAndEqual(cipher, logq);
@@ -1177,11 +2025,7 @@ void Scheme::bootstrapAndEqual(Ciphertext& cipher, long logq, long logQ, long lo
 
 	cipher.logq = logQ;
 	cipher.logp = logq + 4;
-	Ciphertext rot;
-	for (long i = logSlots; i < logNh; ++i) {
-		leftRotateFast(rot, cipher, (1 << i));
-		addAndEqual(cipher, rot);
-	}
+	sumSlotsAndEqual(cipher, cipher.n, Nh / cipher.n);
 
 	divByPo2AndEqual(cipher, logNh); // bitDown: context.logNh - logSlots
 	coeffToSlotAndEqual(cipher);
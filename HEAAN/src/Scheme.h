@@ -11,11 +11,17 @@
 #include <NTL/RR.h>
 #include <NTL/ZZ.h>
 #include <complex>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 #include "BootContext.h"
 #include "SecretKey.h"
 #include "Ciphertext.h"
+#include "CiphertextNTT.h"
+#include "CiphertextTensor.h"
 #include "Plaintext.h"
+#include "PlaintextNTT.h"
 #include "Key.h"
 #include "EvaluatorUtils.h"
 #include "Ring.h"
@@ -27,6 +33,15 @@ static long ENCRYPTION = 0;
 static long MULTIPLICATION  = 1;
 static long CONJUGATION = 2;
 
+/**
+ * Cached encoding of a multByConstVec vector with the values it was encoded from.
+ */
+struct ConstVecEntry {
+	vector<complex<double>> vals;
+	shared_ptr<PlaintextNTT> plain;
+	long lastUse; ///< value of constVecClock when the entry was last used
+};
+
 class Scheme {
 private:
 public:
@@ -40,6 +55,13 @@ public:
 	map<long, string> serKeyMap; ///< contain Encryption, Multiplication and Conjugation keys, if generated
 	map<long, string> serLeftRotKeyMap; ///< contain left rotation keys, if generated
 
+	mutex keyMutex; ///< guards the key maps, so keys can be generated while other threads evaluate
+
+	map<complex<double>*, ConstVecEntry> constVecCache; ///< encoded vectors of multByConstVec with the values they were encoded from
+	long constVecCacheSize = 16; ///< most entries kept in constVecCache, the least recently used one is evicted beyond it
+	long constVecClock = 0;
+	mutex constVecMutex;
+
 	Scheme(SecretKey& secretKey, Ring& ring, bool isSerialized = false);
 
 	//----------------------------------------------------------------------------------
@@ -47,21 +69,33 @@ public:
 	//----------------------------------------------------------------------------------
 
 
-	void addEncKey(SecretKey& secretKey);
+	void addEncKey(SecretKey& secretKey, RandomStream& stream = GetCurrentRandomStream());
+
+	void addMultKey(SecretKey& secretKey, RandomStream& stream = GetCurrentRandomStream());
+
+	void addConjKey(SecretKey& secretKey, RandomStream& stream = GetCurrentRandomStream());
+
+	void addLeftRotKey(SecretKey& secretKey, long r, RandomStream& stream = GetCurrentRandomStream());
+
+	void addRightRotKey(SecretKey& secretKey, long r, RandomStream& stream = GetCurrentRandomStream());
+
+	void addLeftRotKeys(SecretKey& secretKey, RandomStream& stream = GetCurrentRandomStream());
+
+	void addRightRotKeys(SecretKey& secretKey, RandomStream& stream = GetCurrentRandomStream());
 
-	void addMultKey(SecretKey& secretKey);
+	void addBootKey(SecretKey& secretKey, long logl, long logp, RandomStream& stream = GetCurrentRandomStream());
 
-	void addConjKey(SecretKey& secretKey);
+	void insertKey(long type, Key* key, string path);
 
-	void addLeftRotKey(SecretKey& secretKey, long r);
+	void insertLeftRotKey(long r, Key* key, string path);
 
-	void addRightRotKey(SecretKey& secretKey, long r);
+	bool hasLeftRotKey(long r);
 
-	void addLeftRotKeys(SecretKey& secretKey);
+	vector<long> leftRotKeySteps(long r);
 
-	void addRightRotKeys(SecretKey& secretKey);
+	Key* getKey(long type);
 
-	void addBootKey(SecretKey& secretKey, long logl, long logp);
+	Key* getLeftRotKey(long r);
 
 
 	//----------------------------------------------------------------------------------
@@ -75,12 +109,22 @@ public:
 
 	complex<double>* decode(Plaintext& plain);
 
+	void decode(complex<double>* vals, Plaintext& plain);
+
 	void encodeSingle(Plaintext& plain, complex<double> val, long logp, long logq);
 
 	void encodeSingle(Plaintext& plain, double val, long logp, long logq);
 
 	complex<double> decodeSingle(Plaintext& plain);
 
+	void encodeNTT(PlaintextNTT& plain, complex<double>* vals, long n, long logp, long logq);
+
+	void encodeNTT(PlaintextNTT& plain, double* vals, long n, long logp, long logq);
+
+	void encodeNTT(PlaintextNTT& res, Plaintext& plain);
+
+	void encodeNTT(PlaintextNTT& plain, ZZ* mx, long logp, long logq, long n);
+
 
 	//----------------------------------------------------------------------------------
 	//   ENCRYPTION & DECRYPTION
@@ -95,10 +139,28 @@ public:
 
 	void encrypt(Ciphertext& cipher, double* vals, long n, long logp, long logq);
 
+	void encryptTwoReal(Ciphertext& cipher, double* vals1, double* vals2, long n, long logp, long logq);
+
+	void encryptBatch(Ciphertext* ciphers, complex<double>** vals, long count, long n, long logp, long logq);
+
+	void encryptBatch(Ciphertext* ciphers, double** vals, long count, long n, long logp, long logq);
+
 	void encryptZeros(Ciphertext& cipher, long n, long logp, long logq);
 
+	void encryptSymmetric(Ciphertext& cipher, unsigned char* seed, complex<double>* vals, long n, long logp, long logq, SecretKey& secretKey);
+
+	void encryptSymmetric(Ciphertext& cipher, unsigned char* seed, double* vals, long n, long logp, long logq, SecretKey& secretKey);
+
+	void encryptSymmetricMsg(Ciphertext& cipher, unsigned char* seed, ZZ* mx, SecretKey& secretKey);
+
 	complex<double>* decrypt(SecretKey& secretKey, Ciphertext& cipher);
 
+	void decrypt(complex<double>* vals, SecretKey& secretKey, Ciphertext& cipher);
+
+	void decryptTwoReal(double* vals1, double* vals2, SecretKey& secretKey, Ciphertext& cipher);
+
+	void decryptBatch(complex<double>** vals, SecretKey& secretKey, Ciphertext* ciphers, long count);
+
 	void encryptSingle(Ciphertext& cipher, complex<double> val, long logp, long logq);
 
 	void encryptSingle(Ciphertext& cipher, double val, long logp, long logq);
@@ -106,6 +168,16 @@ public:
 	complex<double> decryptSingle(SecretKey& secretKey, Ciphertext& cipher);
 
 
+	//----------------------------------------------------------------------------------
+	//   NTT CACHE
+	//----------------------------------------------------------------------------------
+
+
+	void loadNTT(uint64_t*& ra, uint64_t*& rb, Ciphertext& cipher, long np);
+
+	void unloadNTT(uint64_t* ra, uint64_t* rb, Ciphertext& cipher);
+
+
 	//----------------------------------------------------------------------------------
 	//   HOMOMORPHIC OPERATIONS
 	//----------------------------------------------------------------------------------
@@ -118,6 +190,8 @@ public:
 
 	void addAndEqual(Ciphertext& cipher1, Ciphertext& cipher2);
 
+	void sumMany(Ciphertext& res, Ciphertext* ciphers, long count);
+
 	void addConst(Ciphertext& res, Ciphertext& cipher, double cnst, long logp);
 
 	void addConst(Ciphertext& res, Ciphertext& cipher, RR& cnst, long logp);
@@ -158,6 +232,14 @@ public:
 
 	void multByConstVec(Ciphertext& res, Ciphertext& cipher, complex<double>* cnstVec, long logp);
 
+	void multByConstVecAndEqual(Ciphertext& cipher, complex<double>* cnstVec, long logp);
+
+	void multByConstVecBatch(Ciphertext* res, Ciphertext* ciphers, long count, complex<double>* cnstVec, long logp);
+
+	shared_ptr<PlaintextNTT> loadConstVec(complex<double>* cnstVec, long n, long logp, long logq);
+
+	void clearConstVecCache();
+
 	void multByConstAndEqual(Ciphertext& cipher, double cnst, long logp);
 
 	void multByConstAndEqual(Ciphertext& cipher, RR& cnst, long logp);
@@ -172,6 +254,10 @@ public:
 
 	void multByPolyNTTAndEqual(Ciphertext& cipher, uint64_t* rpoly, long bnd, long logp);
 
+	void multByPoly(Ciphertext& res, Ciphertext& cipher, PlaintextNTT& plain);
+
+	void multByPolyAndEqual(Ciphertext& cipher, PlaintextNTT& plain);
+
 	void multByMonomial(Ciphertext& res, Ciphertext& cipher, const long degree);
 
 	void multByMonomialAndEqual(Ciphertext& cipher, const long degree);
@@ -220,10 +306,82 @@ public:
 	void leftRotateFastAndEqual(Ciphertext& cipher, long r);
 	void rightRotateFastAndEqual(Ciphertext& cipher, long r);
 
+	void leftRotateFastHoisted(Ciphertext* res, Ciphertext& cipher, long* rvec, long count);
+
+	void leftRotateByKeys(Ciphertext& res, Ciphertext& cipher, long r);
+
+	void sumSlots(Ciphertext& res, Ciphertext& cipher, long blockSize, long count, bool conjFold = false);
+	void sumSlotsAndEqual(Ciphertext& cipher, long blockSize, long count, bool conjFold = false);
+
+	void replicateSlots(Ciphertext& res, Ciphertext& cipher, long blockSize, long count);
+	void replicateSlotsAndEqual(Ciphertext& cipher, long blockSize, long count);
+
+	void rotateAndSumAndEqual(Ciphertext& cipher, long stride, long count, long period = Nh);
+
 	void conjugate(Ciphertext& res, Ciphertext& cipher);
 	void conjugateAndEqual(Ciphertext& cipher);
 
 
+	//----------------------------------------------------------------------------------
+	//   DEFERRED RELINEARIZATION
+	//----------------------------------------------------------------------------------
+
+
+	void multNoRelin(CiphertextTensor& res, Ciphertext& cipher1, Ciphertext& cipher2);
+
+	void add(CiphertextTensor& res, CiphertextTensor& tensor1, CiphertextTensor& tensor2);
+
+	void addAndEqual(CiphertextTensor& tensor1, CiphertextTensor& tensor2);
+
+	void relinearize(Ciphertext& res, CiphertextTensor& tensor);
+
+	void innerProduct(Ciphertext& res, Ciphertext* cipher1, Ciphertext* cipher2, long count, long logp);
+
+
+	//----------------------------------------------------------------------------------
+	//   NTT-RESIDENT OPERATIONS
+	//----------------------------------------------------------------------------------
+
+
+	void toNTT(CiphertextNTT& res, Ciphertext& cipher, long np);
+
+	void fromNTT(Ciphertext& res, CiphertextNTT& cipher);
+
+	void reduceNTTAndEqual(CiphertextNTT& cipher);
+
+	void extendNTTAndEqual(CiphertextNTT& cipher, long np);
+
+	void matchNTT(CiphertextNTT& cipher1, CiphertextNTT& cipher2);
+
+	void fitAddNTT(CiphertextNTT& cipher1, CiphertextNTT& cipher2);
+
+	void add(CiphertextNTT& res, CiphertextNTT& cipher1, CiphertextNTT& cipher2);
+
+	void addAndEqual(CiphertextNTT& cipher1, CiphertextNTT& cipher2);
+
+	void sub(CiphertextNTT& res, CiphertextNTT& cipher1, CiphertextNTT& cipher2);
+
+	void subAndEqual(CiphertextNTT& cipher1, CiphertextNTT& cipher2);
+
+	void multByPolyNTT(CiphertextNTT& res, CiphertextNTT& cipher, uint64_t* rpoly, long bnd, long logp);
+
+	void multByPolyNTTAndEqual(CiphertextNTT& cipher, uint64_t* rpoly, long bnd, long logp);
+
+	void multByPoly(CiphertextNTT& res, CiphertextNTT& cipher, PlaintextNTT& plain);
+
+	void multByPolyAndEqual(CiphertextNTT& cipher, PlaintextNTT& plain);
+
+	void keySwitchNTT(CiphertextNTT& res, CiphertextNTT& cipher, uint64_t* rarot, uint64_t* rbrot, Key* key);
+
+	void leftRotateFast(CiphertextNTT& res, CiphertextNTT& cipher, long r);
+
+	void leftRotateFastAndEqual(CiphertextNTT& cipher, long r);
+
+	void conjugate(CiphertextNTT& res, CiphertextNTT& cipher);
+
+	void conjugateAndEqual(CiphertextNTT& cipher);
+
+
 	//----------------------------------------------------------------------------------
 	//   BOOTSTRAPPING
 	//----------------------------------------------------------------------------------
@@ -231,6 +389,8 @@ public:
 
 	void normalizeAndEqual(Ciphertext& cipher);
 
+	void linearTransformAndEqual(Ciphertext& cipher, uint64_t** rpvec, long* bndvec, long logp);
+
 	void coeffToSlotAndEqual(Ciphertext& cipher);
 
 	void slotToCoeffAndEqual(Ciphertext& cipher);
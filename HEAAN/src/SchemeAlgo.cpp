@@ -7,6 +7,9 @@
 */
 #include "SchemeAlgo.h"
 
+#include <algorithm>
+#include <stdexcept>
+
 
 void SchemeAlgo::powerOf2(Ciphertext& res, Ciphertext& cipher, long logp, long logDegree) {
 	res.copy(cipher);
@@ -46,6 +49,9 @@ void SchemeAlgo::powerExtended(Ciphertext* res, Ciphertext& cipher, long logp, l
 	long logDegree = log2((double)degree);
 	Ciphertext* cpows = new Ciphertext[logDegree + 1];
 	powerOf2Extended(cpows, cipher, logp, logDegree);
+	for (long i = 0; i < logDegree + 1; ++i) {
+		cpows[i].keepNTT = true;
+	}
 	long idx = 0;
 	for (long i = 0; i < logDegree; ++i) {
 		long powi = (1 << i);
@@ -135,3 +141,684 @@ void SchemeAlgo::functionLazy(Ciphertext& res, Ciphertext& cipher, string& funcN
 		}
 	}
 }
+
+//-----------------------------------------
+
+/**
+ * Diagonals of the matrix moving slot src[l] to slot l (none if src[l] < 0), NULL where zero.
+ */
+static complex<double>** permutationDiags(long* src, long slots) {
+	complex<double>** diags = new complex<double>*[slots];
+	for (long l = 0; l < slots; ++l) {
+		diags[l] = NULL;
+	}
+	for (long l = 0; l < slots; ++l) {
+		if(src[l] < 0) continue;
+		long offset = (src[l] - l + slots) % slots;
+		if(diags[offset] == NULL) {
+			diags[offset] = new complex<double>[slots];
+		}
+		diags[offset][l] = 1.0;
+	}
+	return diags;
+}
+
+static void deleteDiags(complex<double>** diags, long slots) {
+	for (long l = 0; l < slots; ++l) {
+		delete[] diags[l];
+	}
+	delete[] diags;
+}
+
+/**
+ * Baby-step size for the diagonals at offsets, minimizing the key switches of
+ * the baby and giant rotations when each one is made of the currently loaded keys.
+ * All sizes are tried when this is cheap, otherwise only powers of two.
+ */
+long SchemeAlgo::babyStepSize(vector<long>& offsets, long slots) {
+	long* cost = new long[slots];
+	cost[0] = 0;
+	for (long r = 1; r < slots; ++r) {
+		cost[r] = scheme.leftRotKeySteps(r).size();
+	}
+
+	bool* used = new bool[slots];
+	fill(used, used + slots, false);
+	long k = 1;
+	long best = -1;
+	bool isSmall = slots * offsets.size() <= (1 << 24);
+	for (long kk = 1; kk <= slots; kk = isSmall ? kk + 1 : kk << 1) {
+		long total = 0;
+		for (size_t i = 0; i < offsets.size(); ++i) {
+			long b = offsets[i] % kk;
+			if(!used[b]) {
+				used[b] = true;
+				total += cost[b];
+			}
+		}
+		for (size_t i = 0; i < offsets.size(); ++i) {
+			used[offsets[i] % kk] = false;
+		}
+		for (size_t i = 0; i < offsets.size(); ++i) {
+			long ki = offsets[i] - offsets[i] % kk;
+			if(!used[ki]) {
+				used[ki] = true;
+				total += cost[ki];
+			}
+		}
+		for (size_t i = 0; i < offsets.size(); ++i) {
+			used[offsets[i] - offsets[i] % kk] = false;
+		}
+		if(best < 0 || total < best) {
+			best = total;
+			k = kk;
+		}
+	}
+	delete[] cost;
+	delete[] used;
+	return k;
+}
+
+/**
+ * diags[l][i] is the matrix entry (i, i + l mod slots), diags[l] = NULL for a zero diagonal.
+ */
+void SchemeAlgo::makeLinearTransformPlan(LinearTransformPlan& plan, complex<double>** diags, long slots, long logp, long logq) {
+	vector<long> offsets;
+	for (long l = 0; l < slots; ++l) {
+		if(diags[l] != NULL) offsets.push_back(l);
+	}
+	long k = babyStepSize(offsets, slots);
+
+	Ring& ring = scheme.ring;
+	plan.resize(slots);
+	plan.k = k;
+	plan.logp = logp;
+	plan.logq = logq;
+
+	// all diagonals share one number of primes, so the baby-step rotations are converted once.
+	// The slot-to-coefficient map is a 1/slots-normalized inverse DFT, so no coefficient exceeds
+	// the largest entry in absolute value, which bounds the encoded coefficients without encoding twice.
+	double maxAbs = 0;
+	for (long l = 0; l < slots; ++l) {
+		if(diags[l] == NULL) continue;
+		for (long i = 0; i < slots; ++i) {
+			maxAbs = max(maxAbs, abs(diags[l][i]));
+		}
+	}
+	long bnd = logp + 1 + (maxAbs > 1 ? (long)ceil(log2(maxAbs)) : 0);
+	long logk = ceil(log2((double)k));
+	long np = ceil((logq + bnd + logN + logk + 2)/(double)pbnd);
+
+	NTL_EXEC_RANGE(slots, first, last);
+	complex<double>* vals = new complex<double>[slots];
+	ZZ* mx = new ZZ[N];
+	for (long l = first; l < last; ++l) {
+		if(diags[l] != NULL) {
+			long ki = l - l % k;
+			for (long i = 0; i < slots; ++i) {
+				vals[(i + ki) % slots] = diags[l][i];
+			}
+			ring.encode(mx, vals, slots, logp);
+			plan.diags[l] = new PlaintextNTT(np, logp, logq, slots);
+			plan.diags[l]->bnd = bnd;
+			ring.CRT(plan.diags[l]->rx, mx, np);
+		}
+	}
+	delete[] vals;
+	delete[] mx;
+	NTL_EXEC_RANGE_END;
+}
+
+/**
+ * matrix is slots x slots in row-major order.
+ */
+void SchemeAlgo::makeLinearTransformPlan(LinearTransformPlan& plan, complex<double>* matrix, long slots, long logp, long logq) {
+	complex<double>** diags = new complex<double>*[slots];
+	for (long l = 0; l < slots; ++l) {
+		diags[l] = new complex<double>[slots];
+		bool isZero = true;
+		for (long i = 0; i < slots; ++i) {
+			diags[l][i] = matrix[i * slots + (i + l) % slots];
+			if(diags[l][i] != 0.0) isZero = false;
+		}
+		if(isZero) {
+			delete[] diags[l];
+			diags[l] = NULL;
+		}
+	}
+	makeLinearTransformPlan(plan, diags, slots, logp, logq);
+	deleteDiags(diags, slots);
+}
+
+/**
+ * Plan moving slot src[l] to slot l, or clearing slot l if src[l] < 0.
+ * It costs one level and the rotations of the plan's baby and giant steps.
+ */
+void SchemeAlgo::makePermutationPlan(LinearTransformPlan& plan, long* src, long slots, long logp, long logq) {
+	complex<double>** diags = permutationDiags(src, slots);
+	makeLinearTransformPlan(plan, diags, slots, logp, logq);
+	deleteDiags(diags, slots);
+}
+
+void SchemeAlgo::permute(Ciphertext& res, Ciphertext& cipher, LinearTransformPlan& plan) {
+	linearTransform(res, cipher, plan);
+}
+
+/**
+ * Plan of a 2-D convolution with zero padding of (kheight - 1) / 2 rows and (kwidth - 1) / 2 columns.
+ * The input holds inChannels maps of height x width slots in row-major order, one after the other,
+ * and the output holds outChannels maps of the strided output size in the same layout.
+ * kernel[((co * inChannels + ci) * kheight + ky) * kwidth + kx] weights input channel ci for output channel co.
+ * Each kernel tap becomes a diagonal masked where it reads padding, so the convolution costs one level
+ * and the hoisted rotations of one linear transform. height = kheight = 1 gives a 1-D convolution.
+ */
+void SchemeAlgo::makeConvPlan(LinearTransformPlan& plan, double* kernel, long kheight, long kwidth, long inChannels, long outChannels,
+		long height, long width, long stride, long slots, long logp, long logq) {
+	if(kheight <= 0 || kwidth <= 0 || inChannels <= 0 || outChannels <= 0 || height <= 0 || width <= 0 || stride <= 0) {
+		throw invalid_argument("convolution sizes and stride must be positive");
+	}
+	long padh = (kheight - 1) / 2;
+	long padw = (kwidth - 1) / 2;
+	if(kheight > height + 2 * padh || kwidth > width + 2 * padw) {
+		throw invalid_argument("convolution kernel is larger than the padded input");
+	}
+	long outHeight = (height + 2 * padh - kheight) / stride + 1;
+	long outWidth = (width + 2 * padw - kwidth) / stride + 1;
+	if(inChannels * height * width > slots || outChannels * outHeight * outWidth > slots) {
+		throw invalid_argument("convolution input or output does not fit in the slots");
+	}
+
+	complex<double>** diags = new complex<double>*[slots];
+	for (long l = 0; l < slots; ++l) {
+		diags[l] = NULL;
+	}
+	for (long co = 0; co < outChannels; ++co) {
+		for (long oy = 0; oy < outHeight; ++oy) {
+			for (long ox = 0; ox < outWidth; ++ox) {
+				long dst = (co * outHeight + oy) * outWidth + ox;
+				for (long ci = 0; ci < inChannels; ++ci) {
+					for (long ky = 0; ky < kheight; ++ky) {
+						long iy = oy * stride + ky - padh;
+						if(iy < 0 || iy >= height) continue;
+						for (long kx = 0; kx < kwidth; ++kx) {
+							long ix = ox * stride + kx - padw;
+							if(ix < 0 || ix >= width) continue;
+							double w = kernel[((co * inChannels + ci) * kheight + ky) * kwidth + kx];
+							if(w == 0) continue;
+							long src = (ci * height + iy) * width + ix;
+							long offset = (src - dst + slots) % slots;
+							if(diags[offset] == NULL) {
+								diags[offset] = new complex<double>[slots];
+							}
+							diags[offset][dst] += w;
+						}
+					}
+				}
+			}
+		}
+	}
+	makeLinearTransformPlan(plan, diags, slots, logp, logq);
+	deleteDiags(diags, slots);
+}
+
+void SchemeAlgo::conv(Ciphertext& res, Ciphertext& cipher, LinearTransformPlan& plan) {
+	linearTransform(res, cipher, plan);
+}
+
+/**
+ * res = matrix * cipher for the matrix encoded in plan, rescaled by plan.logp.
+ * The baby-step rotations with a loaded key are hoisted, the other rotations are made of
+ * loaded keys, and every inner sum is accumulated in NTT form.
+ * Needs cipher.logq <= plan.logq.
+ */
+void SchemeAlgo::linearTransform(Ciphertext& res, Ciphertext& cipher, LinearTransformPlan& plan) {
+	if(cipher.logq > plan.logq) {
+		throw invalid_argument("ciphertext modulus is larger than the plan was built for");
+	}
+	if(cipher.n != plan.slots) {
+		throw invalid_argument("ciphertext and plan have different numbers of slots");
+	}
+	vector<long> babies = plan.babySteps();
+	vector<long> giants = plan.giantSteps();
+	if(giants.empty()) {
+		scheme.multByConst(res, cipher, 0.0, plan.logp);
+		scheme.reScaleByAndEqual(res, plan.logp);
+		return;
+	}
+	long np = 0;
+	for (long l = 0; l < plan.slots && np == 0; ++l) {
+		if(plan.diags[l] != NULL) np = plan.diags[l]->np;
+	}
+
+	vector<long> hoisted, composed;
+	for (size_t j = 0; j < babies.size(); ++j) {
+		if(babies[j] == 0 || scheme.hasLeftRotKey(babies[j])) {
+			hoisted.push_back(babies[j]);
+		} else {
+			composed.push_back(babies[j]);
+		}
+	}
+	Ciphertext* rotvec = new Ciphertext[babies.size()];
+	scheme.leftRotateFastHoisted(rotvec, cipher, hoisted.data(), hoisted.size());
+	NTL_EXEC_RANGE(composed.size(), first, last);
+	for (long j = first; j < last; ++j) {
+		scheme.leftRotateByKeys(rotvec[hoisted.size() + j], cipher, composed[j]);
+	}
+	NTL_EXEC_RANGE_END;
+	hoisted.insert(hoisted.end(), composed.begin(), composed.end());
+
+	CiphertextNTT* rrotvec = new CiphertextNTT[plan.k];
+	NTL_EXEC_RANGE(babies.size(), first, last);
+	for (long j = first; j < last; ++j) {
+		scheme.toNTT(rrotvec[hoisted[j]], rotvec[j], np);
+	}
+	NTL_EXEC_RANGE_END;
+	delete[] rotvec;
+
+	Ciphertext* tmpvec = new Ciphertext[giants.size()];
+	NTL_EXEC_RANGE(giants.size(), first, last);
+	CiphertextNTT racc, rtmp;
+	for (long g = first; g < last; ++g) {
+		long ki = giants[g];
+		bool isEmpty = true;
+		for (long b = 0; b < plan.k && ki + b < plan.slots; ++b) {
+			PlaintextNTT* diag = plan.diags[ki + b];
+			if(diag == NULL) continue;
+			if(isEmpty) {
+				scheme.multByPoly(racc, rrotvec[b], *diag);
+				isEmpty = false;
+			} else {
+				scheme.multByPoly(rtmp, rrotvec[b], *diag);
+				scheme.addAndEqual(racc, rtmp);
+			}
+		}
+		if(ki == 0) {
+			scheme.fromNTT(tmpvec[g], racc);
+		} else {
+			Ciphertext tmp;
+			scheme.fromNTT(tmp, racc);
+			scheme.leftRotateByKeys(tmpvec[g], tmp, ki);
+		}
+	}
+	NTL_EXEC_RANGE_END;
+	delete[] rrotvec;
+
+	res.copy(tmpvec[0]);
+	for (size_t g = 1; g < giants.size(); ++g) {
+		scheme.addAndEqual(res, tmpvec[g]);
+	}
+	delete[] tmpvec;
+	scheme.reScaleByAndEqual(res, plan.logp);
+}
+
+/**
+ * Plan for the product of d x d matrices packed row-major in d^2 slots.
+ */
+void SchemeAlgo::makeMatMulPlan(MatMulPlan& plan, long d, long logp, long logq) {
+	long n = d * d;
+	plan.resize(d);
+	plan.logp = logp;
+	plan.logq = logq;
+
+	long* src = new long[n];
+	for (long i = 0; i < d; ++i) {
+		for (long j = 0; j < d; ++j) {
+			src[i * d + j] = i * d + (i + j) % d;
+		}
+	}
+	makePermutationPlan(plan.sigma, src, n, logp, logq);
+
+	for (long i = 0; i < d; ++i) {
+		for (long j = 0; j < d; ++j) {
+			src[i * d + j] = ((i + j) % d) * d + j;
+		}
+	}
+	makePermutationPlan(plan.tau, src, n, logp, logq);
+	delete[] src;
+
+	NTL_EXEC_RANGE(d - 1, first, last);
+	double* mask = new double[n];
+	double* maskInv = new double[n];
+	for (long k = first + 1; k < last + 1; ++k) {
+		for (long l = 0; l < n; ++l) {
+			mask[l] = (l % d < d - k) ? 1.0 : 0.0;
+			maskInv[l] = 1.0 - mask[l];
+		}
+		plan.colMasks[k] = new PlaintextNTT();
+		plan.colMasksInv[k] = new PlaintextNTT();
+		scheme.encodeNTT(*plan.colMasks[k], mask, n, logp, logq);
+		scheme.encodeNTT(*plan.colMasksInv[k], maskInv, n, logp, logq);
+	}
+	delete[] mask;
+	delete[] maskInv;
+	NTL_EXEC_RANGE_END;
+}
+
+/**
+ * res = cipher1 * cipher2 as d x d matrices packed row-major, consuming three times plan.logp.
+ * The column shifts of sigma(A) and the row shifts of tau(B) are hoisted rotations,
+ * and the d products are summed before a single relinearization.
+ * Needs the left rotation keys of plan.rotations().
+ */
+void SchemeAlgo::matMul(Ciphertext& res, Ciphertext& cipher1, Ciphertext& cipher2, MatMulPlan& plan) {
+	long d = plan.d;
+	long n = d * d;
+	long logp = plan.logp;
+
+	Ciphertext sa, tb;
+	linearTransform(sa, cipher1, plan.sigma);
+	linearTransform(tb, cipher2, plan.tau);
+
+	Ciphertext* avec = new Ciphertext[d];
+	Ciphertext* bvec = new Ciphertext[d];
+	long* rvec = new long[2 * d];
+
+	// phi^k(A) takes columns j < d - k from the left rotation by k, the others from the rotation by k - d
+	for (long k = 1; k < d; ++k) {
+		rvec[2 * k - 2] = k;
+		rvec[2 * k - 1] = n - d + k;
+	}
+	Ciphertext* rotvec = new Ciphertext[2 * d - 2];
+	scheme.leftRotateFastHoisted(rotvec, sa, rvec, 2 * d - 2);
+	NTL_EXEC_RANGE(d - 1, first, last);
+	Ciphertext tmp;
+	for (long k = first + 1; k < last + 1; ++k) {
+		scheme.multByPoly(avec[k], rotvec[2 * k - 2], *plan.colMasks[k]);
+		scheme.multByPoly(tmp, rotvec[2 * k - 1], *plan.colMasksInv[k]);
+		scheme.addAndEqual(avec[k], tmp);
+		scheme.reScaleByAndEqual(avec[k], logp);
+	}
+	NTL_EXEC_RANGE_END;
+	scheme.modDownBy(avec[0], sa, logp);
+	delete[] rotvec;
+
+	// psi^k(B) is the left rotation by k * d
+	scheme.modDownByAndEqual(tb, logp);
+	for (long k = 0; k < d; ++k) {
+		rvec[k] = k * d;
+	}
+	scheme.leftRotateFastHoisted(bvec, tb, rvec, d);
+	delete[] rvec;
+
+	scheme.innerProduct(res, avec, bvec, d, logp);
+
+	delete[] avec;
+	delete[] bvec;
+}
+
+//-----------------------------------------
+
+/**
+ * Diagonals of the radix-2 stage combining blocks of h slots:
+ * y[i] = x[i] + w^j * x[i + h] and y[i + h] = x[i] - w^j * x[i + h], w = exp(-+2 pi i / 2h).
+ */
+static complex<double>** butterflyDiags(long h, long slots, bool isInverse) {
+	complex<double>** diags = new complex<double>*[slots];
+	for (long l = 0; l < slots; ++l) {
+		diags[l] = NULL;
+	}
+	diags[0] = new complex<double>[slots];
+	diags[h] = new complex<double>[slots];
+	if(diags[slots - h] == NULL) {
+		diags[slots - h] = new complex<double>[slots];
+	}
+	double angle = (isInverse ? M_PI : -M_PI) / h;
+	for (long i = 0; i < slots; ++i) {
+		long j = i % (2 * h);
+		if(j < h) {
+			diags[0][i] += 1.0;
+			diags[h][i] += polar(1.0, angle * j);
+		} else {
+			diags[0][i] -= polar(1.0, angle * (j - h));
+			diags[slots - h][i] += 1.0;
+		}
+	}
+	return diags;
+}
+
+/**
+ * Diagonals of A * B: diagonal a of A times diagonal b of B rotated by a lands on diagonal a + b.
+ */
+static complex<double>** composeDiags(complex<double>** A, complex<double>** B, long slots) {
+	complex<double>** res = new complex<double>*[slots];
+	for (long l = 0; l < slots; ++l) {
+		res[l] = NULL;
+	}
+	for (long a = 0; a < slots; ++a) {
+		if(A[a] == NULL) continue;
+		for (long b = 0; b < slots; ++b) {
+			if(B[b] == NULL) continue;
+			long l = (a + b) % slots;
+			if(res[l] == NULL) {
+				res[l] = new complex<double>[slots];
+			}
+			for (long i = 0; i < slots; ++i) {
+				res[l][i] += A[a][i] * B[b][(i + a) % slots];
+			}
+		}
+	}
+	return res;
+}
+
+/**
+ * Plan of the slot DFT as a bit reversal and log(slots) butterfly stages,
+ * merged by groups of merge stages. It consumes 1 + ceil(log(slots) / merge) levels.
+ */
+void SchemeAlgo::makeDFTPlan(DFTPlan& plan, long slots, bool isInverse, long logp, long logq, long merge) {
+	if(slots <= 0 || slots > Nh || (slots & (slots - 1)) != 0) {
+		throw invalid_argument("DFT slots must be a power of two at most Nh");
+	}
+	if(merge < 1) {
+		throw invalid_argument("DFT stages must be merged by groups of at least one");
+	}
+	long logSlots = log2(slots);
+	long ngroups = (logSlots + merge - 1) / merge;
+	plan.resize(1 + ngroups);
+	plan.slots = slots;
+	plan.isInverse = isInverse;
+	plan.logp = logp;
+	plan.logq = logq;
+
+	long* src = new long[slots];
+	for (long i = 0; i < slots; ++i) {
+		src[i] = 0;
+		for (long b = 0; b < logSlots; ++b) {
+			if(i & (1 << b)) src[i] |= 1 << (logSlots - 1 - b);
+		}
+	}
+	complex<double>** diags = permutationDiags(src, slots);
+	delete[] src;
+	if(isInverse) {
+		for (long l = 0; l < slots; ++l) {
+			if(diags[l] == NULL) continue;
+			for (long i = 0; i < slots; ++i) {
+				diags[l][i] /= (double)slots;
+			}
+		}
+	}
+	makeLinearTransformPlan(*plan.stages[0], diags, slots, logp, logq);
+	deleteDiags(diags, slots);
+
+	for (long g = 0; g < ngroups; ++g) {
+		diags = NULL;
+		for (long b = g * merge; b < min((g + 1) * merge, logSlots); ++b) {
+			complex<double>** stage = butterflyDiags(1 << b, slots, isInverse);
+			if(diags == NULL) {
+				diags = stage;
+			} else {
+				complex<double>** merged = composeDiags(stage, diags, slots);
+				deleteDiags(stage, slots);
+				deleteDiags(diags, slots);
+				diags = merged;
+			}
+		}
+		makeLinearTransformPlan(*plan.stages[g + 1], diags, slots, logp, logq);
+		deleteDiags(diags, slots);
+	}
+}
+
+/**
+ * Cached plan with one stage per level, rebuilt if the cached one has another logp
+ * or cannot be applied at logq.
+ */
+shared_ptr<DFTPlan> SchemeAlgo::loadDFTPlan(long slots, bool isInverse, long logp, long logq) {
+	lock_guard<mutex> lock(dftPlanMutex);
+	map<long, shared_ptr<DFTPlan>>& planMap = isInverse ? idftPlanMap : dftPlanMap;
+	auto it = planMap.find(slots);
+	if(it != planMap.end() && it->second->logp == logp && it->second->logq >= logq) {
+		return it->second;
+	}
+	shared_ptr<DFTPlan> plan = make_shared<DFTPlan>();
+	makeDFTPlan(*plan, slots, isInverse, logp, logq);
+	planMap[slots] = plan;
+	return plan;
+}
+
+void SchemeAlgo::dft(Ciphertext& res, Ciphertext& cipher, DFTPlan& plan) {
+	linearTransform(res, cipher, *plan.stages[0]);
+	for (long s = 1; s < plan.nstages; ++s) {
+		linearTransform(res, res, *plan.stages[s]);
+	}
+}
+
+void SchemeAlgo::dft(Ciphertext& res, Ciphertext& cipher, long logp) {
+	shared_ptr<DFTPlan> plan = loadDFTPlan(cipher.n, false, logp, cipher.logq);
+	dft(res, cipher, *plan);
+}
+
+void SchemeAlgo::idft(Ciphertext& res, Ciphertext& cipher, long logp) {
+	shared_ptr<DFTPlan> plan = loadDFTPlan(cipher.n, true, logp, cipher.logq);
+	dft(res, cipher, *plan);
+}
+
+//-----------------------------------------
+
+/**
+ * Number of ciphertexts with cipher.n slots that fit in one full-slot ciphertext.
+ */
+long SchemeAlgo::packingFactor(Ciphertext& cipher) {
+	return Nh / cipher.n;
+}
+
+/**
+ * Masks of the count blocks of n slots in count * n slots, cached and rebuilt
+ * if the cached ones cannot be applied at logq.
+ */
+vector<shared_ptr<PlaintextNTT>> SchemeAlgo::loadPackMasks(long n, long count, long logp, long logq) {
+	lock_guard<mutex> lock(packMaskMutex);
+	tuple<long, long, long> key(n, count, logp);
+	auto it = packMaskMap.find(key);
+	if(it != packMaskMap.end() && it->second[0]->logq >= logq) {
+		return it->second;
+	}
+	long slots = n * count;
+	vector<shared_ptr<PlaintextNTT>> masks(count);
+	NTL_EXEC_RANGE(count, first, last);
+	double* mask = new double[slots];
+	for (long j = first; j < last; ++j) {
+		for (long i = 0; i < slots; ++i) {
+			mask[i] = (i / n == j) ? 1.0 : 0.0;
+		}
+		masks[j] = make_shared<PlaintextNTT>();
+		scheme.encodeNTT(*masks[j], mask, slots, logp, logq);
+	}
+	delete[] mask;
+	NTL_EXEC_RANGE_END;
+	packMaskMap[key] = masks;
+	return masks;
+}
+
+/**
+ * Packs count ciphertexts with n slots, same logp and logq, into one ciphertext with count * n slots,
+ * slots j * n to (j + 1) * n - 1 holding ciphers[j]. An n-slot ciphertext read with count * n slots
+ * repeats its values count times, so each one is masked to its block and the blocks are added.
+ * count * n must be at most Nh and a power of two. Consumes logp bits of modulus and no rotation.
+ */
+void SchemeAlgo::pack(Ciphertext& res, Ciphertext* ciphers, long count, long logp) {
+	if(count <= 0) {
+		throw invalid_argument("pack needs at least one ciphertext");
+	}
+	long n = ciphers[0].n;
+	long slots = n * count;
+	if(slots > Nh || (slots & (slots - 1)) != 0) {
+		throw invalid_argument("packed slots must be a power of two at most Nh");
+	}
+	for (long j = 0; j < count; ++j) {
+		if(ciphers[j].n != n || ciphers[j].logp != ciphers[0].logp || ciphers[j].logq != ciphers[0].logq) {
+			throw invalid_argument("packed ciphertexts must share n, logp and logq");
+		}
+	}
+	vector<shared_ptr<PlaintextNTT>> masks = loadPackMasks(n, count, logp, ciphers[0].logq);
+	Ciphertext* tmpvec = new Ciphertext[count];
+	NTL_EXEC_RANGE(count, first, last);
+	for (long j = first; j < last; ++j) {
+		scheme.multByPoly(tmpvec[j], ciphers[j], *masks[j]);
+	}
+	NTL_EXEC_RANGE_END;
+
+	scheme.sumMany(res, tmpvec, count);
+	res.n = slots;
+	scheme.reScaleByAndEqual(res, logp);
+	delete[] tmpvec;
+}
+
+/**
+ * Inverse of pack: res[j] gets slots j * n to (j + 1) * n - 1 of cipher, with n = cipher.n / count.
+ * Block j is masked and summed over all blocks so that it repeats with period n, as an n-slot ciphertext does.
+ * count must be a power of two dividing cipher.n.
+ * Consumes logp bits of modulus and log(count) rotations per output.
+ */
+void SchemeAlgo::unpack(Ciphertext* res, Ciphertext& cipher, long count, long logp) {
+	long slots = cipher.n;
+	if(count <= 0 || (count & (count - 1)) != 0 || count > slots) {
+		throw invalid_argument("unpack needs a power of two count dividing the slots");
+	}
+	long n = slots / count;
+	vector<shared_ptr<PlaintextNTT>> masks = loadPackMasks(n, count, logp, cipher.logq);
+	NTL_EXEC_RANGE(count, first, last);
+	for (long j = first; j < last; ++j) {
+		scheme.multByPoly(res[j], cipher, *masks[j]);
+		scheme.reScaleByAndEqual(res[j], logp);
+		scheme.sumSlotsAndEqual(res[j], n, count);
+		res[j].n = n;
+	}
+	NTL_EXEC_RANGE_END;
+}
+
+//-----------------------------------------
+
+/**
+ * For cipher encrypting a + i * b with real a and b, res1 encrypts a = (z + conj(z)) / 2
+ * and res2 encrypts b = -i * (z - conj(z)) / 2. Needs the conjugation key.
+ */
+void SchemeAlgo::splitTwoReal(Ciphertext& res1, Ciphertext& res2, Ciphertext& cipher) {
+	Ciphertext cconj;
+	scheme.conjugate(cconj, cipher);
+	scheme.sub(res2, cipher, cconj);
+	scheme.idivAndEqual(res2);
+	scheme.divByPo2AndEqual(res2, 1);
+	scheme.add(res1, cipher, cconj);
+	scheme.divByPo2AndEqual(res1, 1);
+}
+
+/**
+ * For z = a1 + i * b1 and w = a2 + i * b2 with real a1, b1, a2, b2, res encrypts a1 * a2 + i * b1 * b2.
+ * With wc = w + conj(w) = 2 * a2 and wd = -i * (w - conj(w)) = 2 * b2,
+ * P = z * (wc + wd) and Q = z * (wc - wd) give 4 * (a1 * a2 + i * b1 * b2) = P + conj(Q).
+ * Costs two multiplications and two conjugations, and is not rescaled, as mult.
+ */
+void SchemeAlgo::multTwoReal(Ciphertext& res, Ciphertext& cipher1, Ciphertext& cipher2) {
+	Ciphertext wc, wd, tmp;
+	scheme.conjugate(tmp, cipher2);
+	scheme.add(wc, cipher2, tmp);
+	scheme.sub(wd, cipher2, tmp);
+	scheme.idivAndEqual(wd);
+
+	scheme.sub(tmp, wc, wd);
+	scheme.addAndEqual(wc, wd);
+	scheme.mult(res, cipher1, wc);
+	scheme.multAndEqual(tmp, cipher1);
+	scheme.conjugateAndEqual(tmp);
+	scheme.addAndEqual(res, tmp);
+	scheme.divByPo2AndEqual(res, 2);
+}
@@ -10,11 +10,17 @@
 
 #include <NTL/BasicThreadPool.h>
 #include <NTL/ZZ.h>
+#include <memory>
+#include <mutex>
+#include <tuple>
 
 #include "EvaluatorUtils.h"
 #include "Plaintext.h"
 #include "SecretKey.h"
 #include "Ciphertext.h"
+#include "DFTPlan.h"
+#include "LinearTransformPlan.h"
+#include "MatMulPlan.h"
 #include "Scheme.h"
 
 static string LOGARITHM = "Logarithm"; ///< log(x)
@@ -25,6 +31,12 @@ class SchemeAlgo {
 public:
 	Scheme& scheme;
 	map<string, double*> taylorCoeffsMap;
+	map<long, shared_ptr<DFTPlan>> dftPlanMap; ///< cached forward transforms by number of slots
+	map<long, shared_ptr<DFTPlan>> idftPlanMap; ///< cached inverse transforms by number of slots
+	mutex dftPlanMutex;
+
+	map<tuple<long, long, long>, vector<shared_ptr<PlaintextNTT>>> packMaskMap; ///< cached block masks of pack and unpack by (n, count, logp)
+	mutex packMaskMutex;
 
 	SchemeAlgo(Scheme& scheme) : scheme(scheme) {
 		taylorCoeffsMap.insert(pair<string, double*>(LOGARITHM,new double[11] {0,1,-0.5,1./3,-1./4,1./5,-1./6,1./7,-1./8,1./9,-1./10}));
@@ -47,6 +59,49 @@ public:
 
 	void functionLazy(Ciphertext& res, Ciphertext& cipher, string& funcName, long logp, long degree);
 
+	long babyStepSize(vector<long>& offsets, long slots);
+
+	void makeLinearTransformPlan(LinearTransformPlan& plan, complex<double>** diags, long slots, long logp, long logq);
+
+	void makeLinearTransformPlan(LinearTransformPlan& plan, complex<double>* matrix, long slots, long logp, long logq);
+
+	void linearTransform(Ciphertext& res, Ciphertext& cipher, LinearTransformPlan& plan);
+
+	void makePermutationPlan(LinearTransformPlan& plan, long* src, long slots, long logp, long logq);
+
+	void permute(Ciphertext& res, Ciphertext& cipher, LinearTransformPlan& plan);
+
+	void makeConvPlan(LinearTransformPlan& plan, double* kernel, long kheight, long kwidth, long inChannels, long outChannels,
+			long height, long width, long stride, long slots, long logp, long logq);
+
+	void conv(Ciphertext& res, Ciphertext& cipher, LinearTransformPlan& plan);
+
+	void makeMatMulPlan(MatMulPlan& plan, long d, long logp, long logq);
+
+	void matMul(Ciphertext& res, Ciphertext& cipher1, Ciphertext& cipher2, MatMulPlan& plan);
+
+	void makeDFTPlan(DFTPlan& plan, long slots, bool isInverse, long logp, long logq, long merge = 1);
+
+	shared_ptr<DFTPlan> loadDFTPlan(long slots, bool isInverse, long logp, long logq);
+
+	void dft(Ciphertext& res, Ciphertext& cipher, DFTPlan& plan);
+
+	void dft(Ciphertext& res, Ciphertext& cipher, long logp);
+
+	void idft(Ciphertext& res, Ciphertext& cipher, long logp);
+
+	long packingFactor(Ciphertext& cipher);
+
+	vector<shared_ptr<PlaintextNTT>> loadPackMasks(long n, long count, long logp, long logq);
+
+	void pack(Ciphertext& res, Ciphertext* ciphers, long count, long logp);
+
+	void unpack(Ciphertext* res, Ciphertext& cipher, long count, long logp);
+
+	void splitTwoReal(Ciphertext& res1, Ciphertext& res2, Ciphertext& cipher);
+
+	void multTwoReal(Ciphertext& res, Ciphertext& cipher1, Ciphertext& cipher2);
+
 };
 
 #endif
@@ -56,6 +56,53 @@ Ciphertext* SerializationUtils::readCiphertext(string path) {
 	return &cipher;
 }
 
+void SerializationUtils::writeSeededCiphertext(Ciphertext& cipher, unsigned char* seed, string path) {
+	fstream fout;
+	fout.open(path, ios::binary|ios::out);
+	long n = cipher.n;
+	long logp = cipher.logp;
+	long logq = cipher.logq;
+	fout.write(reinterpret_cast<char*>(&n), sizeof(long));
+	fout.write(reinterpret_cast<char*>(&logp), sizeof(long));
+	fout.write(reinterpret_cast<char*>(&logq), sizeof(long));
+	fout.write(reinterpret_cast<char*>(seed), NTL_PRG_KEYLEN);
+
+	long np = ceil(((double)logq + 1)/8);
+	ZZ q = conv<ZZ>(1) << logq;
+	unsigned char* bytes = new unsigned char[np];
+	for (long i = 0; i < N; ++i) {
+		cipher.bx[i] %= q;
+		BytesFromZZ(bytes, cipher.bx[i], np);
+		fout.write(reinterpret_cast<char*>(bytes), np);
+	}
+	delete[] bytes;
+	fout.close();
+}
+
+Ciphertext* SerializationUtils::readSeededCiphertext(Ring& ring, string path) {
+	long n, logp, logq;
+	fstream fin;
+	fin.open(path, ios::binary|ios::in);
+	fin.read(reinterpret_cast<char*>(&n), sizeof(long));
+	fin.read(reinterpret_cast<char*>(&logp), sizeof(long));
+	fin.read(reinterpret_cast<char*>(&logq), sizeof(long));
+	unsigned char seed[NTL_PRG_KEYLEN];
+	fin.read(reinterpret_cast<char*>(seed), NTL_PRG_KEYLEN);
+
+	long np = ceil(((double)logq + 1)/8);
+	unsigned char* bytes = new unsigned char[np];
+	Ciphertext* cipher = new Ciphertext(logp, logq, n);
+	RandomStream stream(seed);
+	ring.sampleUniform2(cipher->ax, logq, stream);
+	for (long i = 0; i < N; ++i) {
+		fin.read(reinterpret_cast<char*>(bytes), np);
+		ZZFromBytes(cipher->bx[i], bytes, np);
+	}
+	delete[] bytes;
+	fin.close();
+	return cipher;
+}
+
 void SerializationUtils::writeKey(Key* key, string path) {
 	fstream fout;
 	fout.open(path, ios::binary|ios::out);
@@ -74,3 +121,44 @@ Key* SerializationUtils::readKey(string path) {
 	return &key;
 }
 
+void SerializationUtils::writeLinearTransformPlan(LinearTransformPlan& plan, string path) {
+	fstream fout;
+	fout.open(path, ios::binary|ios::out);
+	fout.write(reinterpret_cast<char*>(&plan.slots), sizeof(long));
+	fout.write(reinterpret_cast<char*>(&plan.k), sizeof(long));
+	fout.write(reinterpret_cast<char*>(&plan.logp), sizeof(long));
+	fout.write(reinterpret_cast<char*>(&plan.logq), sizeof(long));
+	for (long l = 0; l < plan.slots; ++l) {
+		PlaintextNTT* diag = plan.diags[l];
+		long np = diag != NULL ? diag->np : 0;
+		fout.write(reinterpret_cast<char*>(&np), sizeof(long));
+		if(np > 0) {
+			fout.write(reinterpret_cast<char*>(&diag->bnd), sizeof(long));
+			fout.write(reinterpret_cast<char*>(diag->rx), (np << logN)*sizeof(uint64_t));
+		}
+	}
+	fout.close();
+}
+
+LinearTransformPlan* SerializationUtils::readLinearTransformPlan(string path) {
+	long slots, k, logp, logq;
+	fstream fin;
+	fin.open(path, ios::binary|ios::in);
+	fin.read(reinterpret_cast<char*>(&slots), sizeof(long));
+	fin.read(reinterpret_cast<char*>(&k), sizeof(long));
+	fin.read(reinterpret_cast<char*>(&logp), sizeof(long));
+	fin.read(reinterpret_cast<char*>(&logq), sizeof(long));
+	LinearTransformPlan* plan = new LinearTransformPlan(slots, k, logp, logq);
+	for (long l = 0; l < slots; ++l) {
+		long np;
+		fin.read(reinterpret_cast<char*>(&np), sizeof(long));
+		if(np > 0) {
+			PlaintextNTT* diag = new PlaintextNTT(np, logp, logq, slots);
+			fin.read(reinterpret_cast<char*>(&diag->bnd), sizeof(long));
+			fin.read(reinterpret_cast<char*>(diag->rx), (np << logN)*sizeof(uint64_t));
+			plan->diags[l] = diag;
+		}
+	}
+	fin.close();
+	return plan;
+}
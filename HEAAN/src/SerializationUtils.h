@@ -13,6 +13,8 @@
 #include "Ciphertext.h"
 #include "Params.h"
 #include "Key.h"
+#include "LinearTransformPlan.h"
+#include "Ring.h"
 
 using namespace std;
 using namespace NTL;
@@ -23,8 +25,14 @@ public:
 	static void writeCiphertext(Ciphertext& ciphertext, string path);
 	static Ciphertext* readCiphertext(string path);
 
+	static void writeSeededCiphertext(Ciphertext& ciphertext, unsigned char* seed, string path);
+	static Ciphertext* readSeededCiphertext(Ring& ring, string path);
+
 	static void writeKey(Key* key, string path);
 	static Key* readKey(string path);
+
+	static void writeLinearTransformPlan(LinearTransformPlan& plan, string path);
+	static LinearTransformPlan* readLinearTransformPlan(string path);
 };
 
 #endif /* SERIALIZATIONUTILS_H_ */
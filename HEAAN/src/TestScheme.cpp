@@ -11,6 +11,7 @@
 #include <NTL/ZZ.h>
 
 #include "Ciphertext.h"
+#include "EncryptionPool.h"
 #include "EvaluatorUtils.h"
 #include "Ring.h"
 #include "Scheme.h"
@@ -78,6 +79,103 @@ void TestScheme::testEncryptSingle(long logq, long logp) {
 	cout << "!!! END TEST ENCRYPT SINGLE !!!" << endl;
 }
 
+void TestScheme::testEncryptBatch(long logq, long logp, long logn, long count) {
+	cout << "!!! START TEST ENCRYPT BATCH !!!" << endl;
+	srand(time(NULL));
+	SetNumThreads(8);
+	TimeUtils timeutils;
+	Ring ring;
+	SecretKey secretKey(ring);
+	Scheme scheme(secretKey, ring);
+
+	long n = (1 << logn);
+	complex<double>** mvecs = new complex<double>*[count];
+	for (long i = 0; i < count; ++i) {
+		mvecs[i] = EvaluatorUtils::randomComplexArray(n);
+	}
+	Ciphertext* ciphers = new Ciphertext[count];
+
+	timeutils.start("Encrypt batch");
+	scheme.encryptBatch(ciphers, mvecs, count, n, logp, logq);
+	timeutils.stop("Encrypt batch");
+
+	complex<double>** dvecs = new complex<double>*[count];
+	for (long i = 0; i < count; ++i) {
+		dvecs[i] = new complex<double>[n];
+	}
+
+	timeutils.start("Decrypt batch");
+	scheme.decryptBatch(dvecs, secretKey, ciphers, count);
+	timeutils.stop("Decrypt batch");
+
+	for (long i = 0; i < count; ++i) {
+		StringUtils::compare(mvecs[i], dvecs[i], n, "val");
+	}
+
+	cout << "!!! END TEST ENCRYPT BATCH !!!" << endl;
+}
+
+void TestScheme::testEncryptionPool(long logq, long logp, long logn, long count) {
+	cout << "!!! START TEST ENCRYPTION POOL !!!" << endl;
+	srand(time(NULL));
+	SetNumThreads(8);
+	TimeUtils timeutils;
+	Ring ring;
+	SecretKey secretKey(ring);
+	Scheme scheme(secretKey, ring);
+
+	long n = (1 << logn);
+	EncryptionPool encPool(scheme, logq, count, 4);
+	while(encPool.size() < count) {
+		this_thread::sleep_for(chrono::milliseconds(10));
+	}
+
+	complex<double>* mvec = EvaluatorUtils::randomComplexArray(n);
+	Ciphertext cipher;
+
+	timeutils.start("Encrypt from pool");
+	encPool.encrypt(cipher, mvec, n, logp);
+	timeutils.stop("Encrypt from pool");
+
+	complex<double>* dvec = scheme.decrypt(secretKey, cipher);
+
+	StringUtils::compare(mvec, dvec, n, "val");
+
+	cout << "pool size: " << encPool.size() << ", hits: " << encPool.hits() << ", misses: " << encPool.misses() << ", refills: " << encPool.refills() << endl;
+
+	cout << "!!! END TEST ENCRYPTION POOL !!!" << endl;
+}
+
+void TestScheme::testEncryptSymmetric(long logq, long logp, long logn) {
+	cout << "!!! START TEST ENCRYPT SYMMETRIC !!!" << endl;
+	srand(time(NULL));
+	SetNumThreads(8);
+	TimeUtils timeutils;
+	Ring ring;
+	SecretKey secretKey(ring);
+	Scheme scheme(secretKey, ring);
+
+	long n = (1 << logn);
+	complex<double>* mvec = EvaluatorUtils::randomComplexArray(n);
+	Ciphertext cipher;
+	unsigned char seed[NTL_PRG_KEYLEN];
+
+	timeutils.start("Encrypt symmetric");
+	scheme.encryptSymmetric(cipher, seed, mvec, n, logp, logq, secretKey);
+	timeutils.stop("Encrypt symmetric");
+
+	SerializationUtils::writeSeededCiphertext(cipher, seed, "seeded.txt");
+	Ciphertext* cipherRead = SerializationUtils::readSeededCiphertext(ring, "seeded.txt");
+
+	complex<double>* dvec = scheme.decrypt(secretKey, *cipherRead);
+
+	StringUtils::compare(mvec, dvec, n, "val");
+
+	delete cipherRead;
+
+	cout << "!!! END TEST ENCRYPT SYMMETRIC !!!" << endl;
+}
+
 void TestScheme::testAdd(long logq, long logp, long logn) {
 	cout << "!!! START TEST ADD !!!" << endl;
 
@@ -112,6 +210,40 @@ void TestScheme::testAdd(long logq, long logp, long logn) {
 	cout << "!!! END TEST ADD !!!" << endl;
 }
 
+void TestScheme::testSumMany(long logq, long logp, long logn, long count) {
+	cout << "!!! START TEST SUM MANY !!!" << endl;
+
+	srand(time(NULL));
+	SetNumThreads(8);
+	TimeUtils timeutils;
+	Ring ring;
+	SecretKey secretKey(ring);
+	Scheme scheme(secretKey, ring);
+
+	long n = (1 << logn);
+	complex<double>* msum = new complex<double>[n];
+	Ciphertext* ciphers = new Ciphertext[count];
+	for (long j = 0; j < count; ++j) {
+		complex<double>* mvec = EvaluatorUtils::randomComplexArray(n);
+		for(long i = 0; i < n; i++) {
+			msum[i] += mvec[i];
+		}
+		scheme.encrypt(ciphers[j], mvec, n, logp, logq - (j % 2));
+		delete[] mvec;
+	}
+
+	timeutils.start("Sum many");
+	Ciphertext csum;
+	scheme.sumMany(csum, ciphers, count);
+	timeutils.stop("Sum many");
+
+	complex<double>* dsum = scheme.decrypt(secretKey, csum);
+
+	StringUtils::compare(msum, dsum, n, "sum");
+
+	cout << "!!! END TEST SUM MANY !!!" << endl;
+}
+
 void TestScheme::testMult(long logq, long logp, long logn) {
 	cout << "!!! START TEST MULT !!!" << endl;
 
@@ -145,6 +277,265 @@ void TestScheme::testMult(long logq, long logp, long logn) {
 	cout << "!!! END TEST MULT !!!" << endl;
 }
 
+void TestScheme::testMultNoRelin(long logq, long logp, long logn, long count) {
+	cout << "!!! START TEST MULT NO RELIN !!!" << endl;
+
+	srand(time(NULL));
+	SetNumThreads(8);
+	TimeUtils timeutils;
+	Ring ring;
+	SecretKey secretKey(ring);
+	Scheme scheme(secretKey, ring);
+
+	long n = (1 << logn);
+	complex<double>* msum = new complex<double>[n];
+	Ciphertext* cipher1 = new Ciphertext[count];
+	Ciphertext* cipher2 = new Ciphertext[count];
+	for (long j = 0; j < count; ++j) {
+		complex<double>* mvec1 = EvaluatorUtils::randomComplexArray(n);
+		complex<double>* mvec2 = EvaluatorUtils::randomComplexArray(n);
+		for(long i = 0; i < n; i++) {
+			msum[i] += mvec1[i] * mvec2[i];
+		}
+		scheme.encrypt(cipher1[j], mvec1, n, logp, logq);
+		scheme.encrypt(cipher2[j], mvec2, n, logp, logq);
+		delete[] mvec1;
+		delete[] mvec2;
+	}
+
+	timeutils.start("Sum of products");
+	CiphertextTensor tensor, tmp;
+	scheme.multNoRelin(tensor, cipher1[0], cipher2[0]);
+	for (long j = 1; j < count; ++j) {
+		scheme.multNoRelin(tmp, cipher1[j], cipher2[j]);
+		scheme.addAndEqual(tensor, tmp);
+	}
+	Ciphertext csum;
+	scheme.relinearize(csum, tensor);
+	timeutils.stop("Sum of products");
+
+	complex<double>* dsum = scheme.decrypt(secretKey, csum);
+
+	StringUtils::compare(msum, dsum, n, "sum");
+
+	cout << "!!! END TEST MULT NO RELIN !!!" << endl;
+}
+
+void TestScheme::testInnerProduct(long logq, long logp, long logn, long count) {
+	cout << "!!! START TEST INNER PRODUCT !!!" << endl;
+
+	srand(time(NULL));
+	SetNumThreads(8);
+	TimeUtils timeutils;
+	Ring ring;
+	SecretKey secretKey(ring);
+	Scheme scheme(secretKey, ring);
+
+	long n = (1 << logn);
+	complex<double>* msum = new complex<double>[n];
+	Ciphertext* cipher1 = new Ciphertext[count];
+	Ciphertext* cipher2 = new Ciphertext[count];
+	for (long j = 0; j < count; ++j) {
+		complex<double>* mvec1 = EvaluatorUtils::randomComplexArray(n);
+		complex<double>* mvec2 = EvaluatorUtils::randomComplexArray(n);
+		for(long i = 0; i < n; i++) {
+			msum[i] += mvec1[i] * mvec2[i];
+		}
+		scheme.encrypt(cipher1[j], mvec1, n, logp, logq);
+		scheme.encrypt(cipher2[j], mvec2, n, logp, logq);
+		delete[] mvec1;
+		delete[] mvec2;
+	}
+
+	timeutils.start("Inner product");
+	Ciphertext csum;
+	scheme.innerProduct(csum, cipher1, cipher2, count, logp);
+	timeutils.stop("Inner product");
+
+	complex<double>* dsum = scheme.decrypt(secretKey, csum);
+
+	StringUtils::compare(msum, dsum, n, "inner");
+
+	cout << "!!! END TEST INNER PRODUCT !!!" << endl;
+}
+
+void TestScheme::testMultByPlaintextNTT(long logq, long logp, long logn, long count) {
+	cout << "!!! START TEST MULT BY PLAINTEXT NTT !!!" << endl;
+
+	srand(time(NULL));
+	SetNumThreads(8);
+	TimeUtils timeutils;
+	Ring ring;
+	SecretKey secretKey(ring);
+	Scheme scheme(secretKey, ring);
+
+	long n = (1 << logn);
+	complex<double>* wvec = EvaluatorUtils::randomComplexArray(n);
+	PlaintextNTT weights;
+	scheme.encodeNTT(weights, wvec, n, logp, logq);
+
+	Ciphertext* ciphers = new Ciphertext[count];
+	complex<double>** mvecs = new complex<double>*[count];
+	for (long j = 0; j < count; ++j) {
+		mvecs[j] = EvaluatorUtils::randomComplexArray(n);
+		scheme.encrypt(ciphers[j], mvecs[j], n, logp, logq);
+	}
+
+	timeutils.start("Mult by plaintext NTT");
+	for (long j = 0; j < count; ++j) {
+		scheme.multByPolyAndEqual(ciphers[j], weights);
+	}
+	timeutils.stop("Mult by plaintext NTT");
+
+	for (long j = 0; j < count; ++j) {
+		for (long i = 0; i < n; ++i) {
+			mvecs[j][i] *= wvec[i];
+		}
+		complex<double>* dvec = scheme.decrypt(secretKey, ciphers[j]);
+		StringUtils::compare(mvecs[j], dvec, n, "mult");
+		delete[] dvec;
+	}
+
+	cout << "!!! END TEST MULT BY PLAINTEXT NTT !!!" << endl;
+}
+
+void TestScheme::testMultByConstVec(long logq, long logp, long logn, long count) {
+	cout << "!!! START TEST MULT BY CONST VEC !!!" << endl;
+
+	srand(time(NULL));
+	SetNumThreads(8);
+	TimeUtils timeutils;
+	Ring ring;
+	SecretKey secretKey(ring);
+	Scheme scheme(secretKey, ring);
+
+	long n = (1 << logn);
+	complex<double>* cvec = EvaluatorUtils::randomComplexArray(n);
+
+	Ciphertext* ciphers = new Ciphertext[count];
+	Ciphertext* cres = new Ciphertext[count];
+	complex<double>** mvecs = new complex<double>*[count];
+	for (long j = 0; j < count; ++j) {
+		mvecs[j] = EvaluatorUtils::randomComplexArray(n);
+		scheme.encrypt(ciphers[j], mvecs[j], n, logp, logq);
+	}
+
+	timeutils.start("Mult by const vec");
+	scheme.multByConstVec(cres[0], ciphers[0], cvec, logp);
+	timeutils.stop("Mult by const vec");
+
+	timeutils.start("Mult by const vec batch");
+	scheme.multByConstVecBatch(cres, ciphers, count, cvec, logp);
+	timeutils.stop("Mult by const vec batch");
+
+	for (long j = 0; j < count; ++j) {
+		for (long i = 0; i < n; ++i) {
+			mvecs[j][i] *= cvec[i];
+		}
+		complex<double>* dvec = scheme.decrypt(secretKey, cres[j]);
+		StringUtils::compare(mvecs[j], dvec, n, "mult");
+		delete[] dvec;
+	}
+
+	cout << "!!! END TEST MULT BY CONST VEC !!!" << endl;
+}
+
+void TestScheme::testMultByConst(long logq, long logp, long logn) {
+	cout << "!!! START TEST MULT BY CONST !!!" << endl;
+
+	srand(time(NULL));
+	SetNumThreads(8);
+	TimeUtils timeutils;
+	Ring ring;
+	SecretKey secretKey(ring);
+	Scheme scheme(secretKey, ring);
+
+	long n = (1 << logn);
+	complex<double>* mvec = EvaluatorUtils::randomComplexArray(n);
+	complex<double> cnst = EvaluatorUtils::randomComplex();
+
+	Ciphertext cipher, cmult;
+	scheme.encrypt(cipher, mvec, n, logp, logq);
+
+	timeutils.start("Mult by complex const");
+	scheme.multByConst(cmult, cipher, cnst, logp);
+	timeutils.stop("Mult by complex const");
+
+	timeutils.start("Mult by complex const and equal");
+	scheme.multByConstAndEqual(cipher, cnst, logp);
+	timeutils.stop("Mult by complex const and equal");
+
+	for (long i = 0; i < n; ++i) {
+		mvec[i] *= cnst;
+	}
+	complex<double>* dvec = scheme.decrypt(secretKey, cmult);
+	StringUtils::compare(mvec, dvec, n, "mult");
+	delete[] dvec;
+
+	dvec = scheme.decrypt(secretKey, cipher);
+	StringUtils::compare(mvec, dvec, n, "mult and equal");
+	delete[] dvec;
+
+	cout << "!!! END TEST MULT BY CONST !!!" << endl;
+}
+
+void TestScheme::testTwoReal(long logq, long logp, long logn) {
+	cout << "!!! START TEST TWO REAL !!!" << endl;
+
+	srand(time(NULL));
+	SetNumThreads(8);
+	TimeUtils timeutils;
+	Ring ring;
+	SecretKey secretKey(ring);
+	Scheme scheme(secretKey, ring);
+	SchemeAlgo algo(scheme);
+	scheme.addConjKey(secretKey);
+
+	long n = (1 << logn);
+	double* avec1 = EvaluatorUtils::randomRealArray(n);
+	double* bvec1 = EvaluatorUtils::randomRealArray(n);
+	double* avec2 = EvaluatorUtils::randomRealArray(n);
+	double* bvec2 = EvaluatorUtils::randomRealArray(n);
+
+	Ciphertext cipher1, cipher2, cmult, ca, cb;
+	timeutils.start("Encrypt two real");
+	scheme.encryptTwoReal(cipher1, avec1, bvec1, n, logp, logq);
+	timeutils.stop("Encrypt two real");
+	scheme.encryptTwoReal(cipher2, avec2, bvec2, n, logp, logq);
+
+	timeutils.start("Mult two real");
+	algo.multTwoReal(cmult, cipher1, cipher2);
+	scheme.reScaleByAndEqual(cmult, logp);
+	timeutils.stop("Mult two real");
+
+	timeutils.start("Split two real");
+	algo.splitTwoReal(ca, cb, cmult);
+	timeutils.stop("Split two real");
+
+	double* amult = new double[n];
+	double* bmult = new double[n];
+	for (long i = 0; i < n; ++i) {
+		amult[i] = avec1[i] * avec2[i];
+		bmult[i] = bvec1[i] * bvec2[i];
+	}
+
+	double* dvec1 = new double[n];
+	double* dvec2 = new double[n];
+	scheme.decryptTwoReal(dvec1, dvec2, secretKey, cmult);
+	StringUtils::compare(amult, dvec1, n, "mult real");
+	StringUtils::compare(bmult, dvec2, n, "mult imag");
+
+	scheme.decryptTwoReal(dvec1, dvec2, secretKey, ca);
+	StringUtils::compare(amult, dvec1, n, "split first");
+	scheme.decryptTwoReal(dvec1, dvec2, secretKey, cb);
+	StringUtils::compare(bmult, dvec1, n, "split second");
+
+	delete[] avec1; delete[] bvec1; delete[] avec2; delete[] bvec2;
+	delete[] amult; delete[] bmult; delete[] dvec1; delete[] dvec2;
+
+	cout << "!!! END TEST TWO REAL !!!" << endl;
+}
+
 void TestScheme::testiMult(long logq, long logp, long logn) {
 	cout << "!!! START TEST i MULTIPLICATION !!!" << endl;
 
@@ -246,6 +637,441 @@ void TestScheme::testConjugate(long logq, long logp, long logn) {
 	cout << "!!! END TEST CONJUGATE !!!" << endl;
 }
 
+void TestScheme::testRotateFastNTT(long logq, long logp, long logn, long logr) {
+	cout << "!!! START TEST ROTATE FAST NTT !!!" << endl;
+
+	srand(time(NULL));
+	SetNumThreads(8);
+	TimeUtils timeutils;
+	Ring ring;
+	SecretKey secretKey(ring);
+	Scheme scheme(secretKey, ring);
+
+	long n = (1 << logn);
+	long r = (1 << logr);
+	scheme.addLeftRotKey(secretKey, r);
+	complex<double>* mvec1 = EvaluatorUtils::randomComplexArray(n);
+	complex<double>* mvec2 = EvaluatorUtils::randomComplexArray(n);
+	Ciphertext cipher1, cipher2;
+	scheme.encrypt(cipher1, mvec1, n, logp, logq);
+	scheme.encrypt(cipher2, mvec2, n, logp, logq);
+
+	long np = ceil((logq + logN + 4)/(double)pbnd);
+	CiphertextNTT rcipher1, rcipher2;
+	scheme.toNTT(rcipher1, cipher1, np);
+	scheme.toNTT(rcipher2, cipher2, np);
+
+	timeutils.start("Left Rotate Fast NTT");
+	scheme.leftRotateFastAndEqual(rcipher1, r);
+	timeutils.stop("Left Rotate Fast NTT");
+
+	scheme.addAndEqual(rcipher1, rcipher2);
+	scheme.fromNTT(cipher1, rcipher1);
+
+	complex<double>* dvec = scheme.decrypt(secretKey, cipher1);
+
+	EvaluatorUtils::leftRotateAndEqual(mvec1, n, r);
+	for (long i = 0; i < n; ++i) {
+		mvec1[i] += mvec2[i];
+	}
+	StringUtils::compare(mvec1, dvec, n, "rot");
+
+	cout << "!!! END TEST ROTATE FAST NTT !!!" << endl;
+}
+
+
+void TestScheme::testSumSlots(long logq, long logp, long logn) {
+	cout << "!!! START TEST SUM SLOTS !!!" << endl;
+
+	srand(time(NULL));
+	SetNumThreads(8);
+	TimeUtils timeutils;
+	Ring ring;
+	SecretKey secretKey(ring);
+	Scheme scheme(secretKey, ring);
+	scheme.addLeftRotKeys(secretKey);
+	scheme.addConjKey(secretKey);
+
+	long n = (1 << logn);
+	complex<double>* mvec = EvaluatorUtils::randomComplexArray(n);
+	Ciphertext cipher, csum;
+	scheme.encrypt(cipher, mvec, n, logp, logq);
+
+	timeutils.start("Sum slots");
+	scheme.sumSlots(csum, cipher, 1, n);
+	timeutils.stop("Sum slots");
+
+	complex<double>* svec = new complex<double>[n];
+	for (long i = 0; i < n; ++i) {
+		svec[0] += mvec[i];
+	}
+	for (long i = 1; i < n; ++i) {
+		svec[i] = svec[0];
+	}
+	complex<double>* dvec = scheme.decrypt(secretKey, csum);
+	StringUtils::compare(svec, dvec, n, "sum");
+	delete[] dvec;
+
+	long blockSize = 2, count = 3;
+	timeutils.start("Sum blocks real");
+	scheme.sumSlots(csum, cipher, blockSize, count, true);
+	timeutils.stop("Sum blocks real");
+
+	for (long i = 0; i < n; ++i) {
+		svec[i] = 0;
+		for (long t = 0; t < count; ++t) {
+			svec[i] += mvec[(i + t * blockSize) % n].real();
+		}
+	}
+	dvec = scheme.decrypt(secretKey, csum);
+	StringUtils::compare(svec, dvec, n, "sum blocks");
+	delete[] dvec;
+
+	for (long i = blockSize; i < n; ++i) {
+		mvec[i] = 0;
+	}
+	scheme.encrypt(cipher, mvec, n, logp, logq);
+	timeutils.start("Replicate slots");
+	scheme.replicateSlotsAndEqual(cipher, blockSize, n / blockSize);
+	timeutils.stop("Replicate slots");
+
+	for (long i = 0; i < n; ++i) {
+		svec[i] = mvec[i % blockSize];
+	}
+	dvec = scheme.decrypt(secretKey, cipher);
+	StringUtils::compare(svec, dvec, n, "replicate");
+	delete[] dvec;
+
+	cout << "!!! END TEST SUM SLOTS !!!" << endl;
+}
+
+
+//----------------------------------------------------------------------------------
+//   LINEAR ALGEBRA TESTS
+//----------------------------------------------------------------------------------
+
+
+void TestScheme::testLinearTransform(long logq, long logp, long logn) {
+	cout << "!!! START TEST LINEAR TRANSFORM !!!" << endl;
+
+	srand(time(NULL));
+	SetNumThreads(8);
+	TimeUtils timeutils;
+	Ring ring;
+	SecretKey secretKey(ring);
+	Scheme scheme(secretKey, ring);
+	SchemeAlgo algo(scheme);
+
+	long n = (1 << logn);
+	complex<double>* matrix = EvaluatorUtils::randomComplexArray(n * n);
+	complex<double>* mvec = EvaluatorUtils::randomComplexArray(n);
+	complex<double>* mmvec = new complex<double>[n];
+	for (long i = 0; i < n; ++i) {
+		for (long j = 0; j < n; ++j) {
+			mmvec[i] += matrix[i * n + j] * mvec[j];
+		}
+	}
+
+	LinearTransformPlan plan;
+	timeutils.start("Linear transform plan");
+	algo.makeLinearTransformPlan(plan, matrix, n, logp, logq);
+	timeutils.stop("Linear transform plan");
+
+	vector<long> rots = plan.rotations();
+	for (size_t i = 0; i < rots.size(); ++i) {
+		scheme.addLeftRotKey(secretKey, rots[i]);
+	}
+	cout << "baby step: " << plan.k << ", rotation keys: " << rots.size() << endl;
+
+	Ciphertext cipher, cres;
+	scheme.encrypt(cipher, mvec, n, logp, logq);
+
+	timeutils.start("Linear transform");
+	algo.linearTransform(cres, cipher, plan);
+	timeutils.stop("Linear transform");
+
+	complex<double>* dvec = scheme.decrypt(secretKey, cres);
+	StringUtils::compare(mmvec, dvec, n, "lintrans");
+	delete[] dvec;
+
+	SerializationUtils::writeLinearTransformPlan(plan, "plan.txt");
+	LinearTransformPlan* plan2 = SerializationUtils::readLinearTransformPlan("plan.txt");
+	algo.linearTransform(cres, cipher, *plan2);
+	dvec = scheme.decrypt(secretKey, cres);
+	StringUtils::compare(mmvec, dvec, n, "lintrans read");
+	delete[] dvec;
+	delete plan2;
+
+	cout << "!!! END TEST LINEAR TRANSFORM !!!" << endl;
+}
+
+void TestScheme::testPermute(long logq, long logp, long logn) {
+	cout << "!!! START TEST PERMUTE !!!" << endl;
+
+	srand(time(NULL));
+	SetNumThreads(8);
+	TimeUtils timeutils;
+	Ring ring;
+	SecretKey secretKey(ring);
+	Scheme scheme(secretKey, ring);
+	SchemeAlgo algo(scheme);
+	scheme.addLeftRotKeys(secretKey);
+
+	long n = (1 << logn);
+	long* src = new long[n];
+	for (long i = 0; i < n; ++i) {
+		src[i] = i;
+	}
+	for (long i = n - 1; i > 0; --i) {
+		swap(src[i], src[rand() % (i + 1)]);
+	}
+	complex<double>* mvec = EvaluatorUtils::randomComplexArray(n);
+	complex<double>* pvec = new complex<double>[n];
+	for (long i = 0; i < n; ++i) {
+		pvec[i] = mvec[src[i]];
+	}
+
+	LinearTransformPlan plan;
+	timeutils.start("Permutation plan");
+	algo.makePermutationPlan(plan, src, n, logp, logq);
+	timeutils.stop("Permutation plan");
+	cout << "baby step: " << plan.k << ", rotations: " << plan.rotations().size() << endl;
+
+	Ciphertext cipher, cperm;
+	scheme.encrypt(cipher, mvec, n, logp, logq);
+
+	timeutils.start("Permute");
+	algo.permute(cperm, cipher, plan);
+	timeutils.stop("Permute");
+
+	complex<double>* dvec = scheme.decrypt(secretKey, cperm);
+	StringUtils::compare(pvec, dvec, n, "permute");
+
+	cout << "!!! END TEST PERMUTE !!!" << endl;
+}
+
+void TestScheme::testMatMul(long logq, long logp, long logd) {
+	cout << "!!! START TEST MATRIX MULTIPLICATION !!!" << endl;
+
+	srand(time(NULL));
+	SetNumThreads(8);
+	TimeUtils timeutils;
+	Ring ring;
+	SecretKey secretKey(ring);
+	Scheme scheme(secretKey, ring);
+	SchemeAlgo algo(scheme);
+
+	long d = (1 << logd);
+	long n = d * d;
+	complex<double>* mvec1 = EvaluatorUtils::randomComplexArray(n);
+	complex<double>* mvec2 = EvaluatorUtils::randomComplexArray(n);
+	complex<double>* mmvec = new complex<double>[n];
+	for (long i = 0; i < d; ++i) {
+		for (long j = 0; j < d; ++j) {
+			for (long k = 0; k < d; ++k) {
+				mmvec[i * d + j] += mvec1[i * d + k] * mvec2[k * d + j];
+			}
+		}
+	}
+
+	MatMulPlan plan;
+	timeutils.start("Matrix multiplication plan");
+	algo.makeMatMulPlan(plan, d, logp, logq);
+	timeutils.stop("Matrix multiplication plan");
+
+	vector<long> rots = plan.rotations();
+	for (size_t i = 0; i < rots.size(); ++i) {
+		scheme.addLeftRotKey(secretKey, rots[i]);
+	}
+	cout << "rotation keys: " << rots.size() << endl;
+
+	Ciphertext cipher1, cipher2, cmult;
+	scheme.encrypt(cipher1, mvec1, n, logp, logq);
+	scheme.encrypt(cipher2, mvec2, n, logp, logq);
+
+	timeutils.start("Matrix multiplication");
+	algo.matMul(cmult, cipher1, cipher2, plan);
+	timeutils.stop("Matrix multiplication");
+
+	complex<double>* dvec = scheme.decrypt(secretKey, cmult);
+	StringUtils::compare(mmvec, dvec, n, "matmul");
+
+	cout << "!!! END TEST MATRIX MULTIPLICATION !!!" << endl;
+}
+
+void TestScheme::testConvolution(long logq, long logp, long logn, long stride) {
+	cout << "!!! START TEST CONVOLUTION !!!" << endl;
+
+	srand(time(NULL));
+	SetNumThreads(8);
+	TimeUtils timeutils;
+	Ring ring;
+	SecretKey secretKey(ring);
+	Scheme scheme(secretKey, ring);
+	SchemeAlgo algo(scheme);
+	scheme.addLeftRotKeys(secretKey);
+
+	long n = (1 << logn);
+	long channels = 2, ksize = 3;
+	long width = 1 << ((logn - 1) / 2);
+	long height = n / channels / width;
+	long outHeight = (height - 1) / stride + 1;
+	long outWidth = (width - 1) / stride + 1;
+
+	double* kernel = EvaluatorUtils::randomRealArray(channels * channels * ksize * ksize);
+	double* mvec = EvaluatorUtils::randomRealArray(n);
+	complex<double>* cvec = new complex<double>[n];
+	for (long co = 0; co < channels; ++co) {
+		for (long oy = 0; oy < outHeight; ++oy) {
+			for (long ox = 0; ox < outWidth; ++ox) {
+				for (long ci = 0; ci < channels; ++ci) {
+					for (long ky = 0; ky < ksize; ++ky) {
+						for (long kx = 0; kx < ksize; ++kx) {
+							long iy = oy * stride + ky - 1;
+							long ix = ox * stride + kx - 1;
+							if(iy < 0 || iy >= height || ix < 0 || ix >= width) continue;
+							cvec[(co * outHeight + oy) * outWidth + ox] += kernel[((co * channels + ci) * ksize + ky) * ksize + kx] * mvec[(ci * height + iy) * width + ix];
+						}
+					}
+				}
+			}
+		}
+	}
+
+	LinearTransformPlan plan;
+	timeutils.start("Convolution plan");
+	algo.makeConvPlan(plan, kernel, ksize, ksize, channels, channels, height, width, stride, n, logp, logq);
+	timeutils.stop("Convolution plan");
+	cout << "baby step: " << plan.k << ", rotations: " << plan.rotations().size() << endl;
+
+	Ciphertext cipher, cconv;
+	scheme.encrypt(cipher, mvec, n, logp, logq);
+
+	timeutils.start("Convolution");
+	algo.conv(cconv, cipher, plan);
+	timeutils.stop("Convolution");
+
+	complex<double>* dvec = scheme.decrypt(secretKey, cconv);
+	StringUtils::compare(cvec, dvec, channels * outHeight * outWidth, "conv");
+
+	cout << "!!! END TEST CONVOLUTION !!!" << endl;
+}
+
+void TestScheme::testDFT(long logq, long logp, long logn) {
+	cout << "!!! START TEST DFT !!!" << endl;
+
+	srand(time(NULL));
+	SetNumThreads(8);
+	TimeUtils timeutils;
+	Ring ring;
+	SecretKey secretKey(ring);
+	Scheme scheme(secretKey, ring);
+	SchemeAlgo algo(scheme);
+
+	long n = (1 << logn);
+	complex<double>* mvec = EvaluatorUtils::randomComplexArray(n);
+	complex<double>* fvec = new complex<double>[n];
+	for (long k = 0; k < n; ++k) {
+		for (long j = 0; j < n; ++j) {
+			fvec[k] += mvec[j] * polar(1.0, -2 * M_PI * j * k / n);
+		}
+	}
+
+	timeutils.start("DFT plans");
+	shared_ptr<DFTPlan> plan = algo.loadDFTPlan(n, false, logp, logq);
+	shared_ptr<DFTPlan> planInv = algo.loadDFTPlan(n, true, logp, logq);
+	timeutils.stop("DFT plans");
+
+	vector<long> rots = plan->rotations();
+	vector<long> rotsInv = planInv->rotations();
+	rots.insert(rots.end(), rotsInv.begin(), rotsInv.end());
+	for (size_t i = 0; i < rots.size(); ++i) {
+		if(!scheme.hasLeftRotKey(rots[i])) {
+			scheme.addLeftRotKey(secretKey, rots[i]);
+		}
+	}
+
+	Ciphertext cipher, cdft, cidft;
+	scheme.encrypt(cipher, mvec, n, logp, logq);
+
+	timeutils.start("DFT");
+	algo.dft(cdft, cipher, logp);
+	timeutils.stop("DFT");
+
+	timeutils.start("IDFT");
+	algo.idft(cidft, cdft, logp);
+	timeutils.stop("IDFT");
+
+	complex<double>* dvec = scheme.decrypt(secretKey, cdft);
+	StringUtils::compare(fvec, dvec, n, "dft");
+	delete[] dvec;
+
+	dvec = scheme.decrypt(secretKey, cidft);
+	StringUtils::compare(mvec, dvec, n, "idft");
+	delete[] dvec;
+
+	cout << "!!! END TEST DFT !!!" << endl;
+}
+
+void TestScheme::testPack(long logq, long logp, long logn, long count) {
+	cout << "!!! START TEST PACK !!!" << endl;
+
+	srand(time(NULL));
+	SetNumThreads(8);
+	TimeUtils timeutils;
+	Ring ring;
+	SecretKey secretKey(ring);
+	Scheme scheme(secretKey, ring);
+	SchemeAlgo algo(scheme);
+	scheme.addLeftRotKeys(secretKey);
+
+	long n = (1 << logn);
+	complex<double>** mvecs = new complex<double>*[count];
+	Ciphertext* ciphers = new Ciphertext[count];
+	for (long j = 0; j < count; ++j) {
+		mvecs[j] = EvaluatorUtils::randomComplexArray(n);
+		scheme.encrypt(ciphers[j], mvecs[j], n, logp, logq);
+	}
+	cout << "packing factor: " << algo.packingFactor(ciphers[0]) << ", packing " << count << endl;
+
+	Ciphertext packed;
+	timeutils.start("Pack");
+	algo.pack(packed, ciphers, count, logp);
+	timeutils.stop("Pack");
+
+	Ciphertext tmp;
+	timeutils.start("Square each");
+	for (long j = 0; j < count; ++j) {
+		scheme.square(tmp, ciphers[j]);
+		scheme.reScaleByAndEqual(tmp, logp);
+	}
+	timeutils.stop("Square each");
+	double timeEach = timeutils.timeElapsed;
+
+	timeutils.start("Square packed");
+	scheme.squareAndEqual(packed);
+	scheme.reScaleByAndEqual(packed, logp);
+	timeutils.stop("Square packed");
+	double timePacked = timeutils.timeElapsed;
+	cout << "amortized gain: " << timeEach / timePacked << endl;
+
+	Ciphertext* unpacked = new Ciphertext[count];
+	timeutils.start("Unpack");
+	algo.unpack(unpacked, packed, count, logp);
+	timeutils.stop("Unpack");
+
+	for (long j = 0; j < count; ++j) {
+		for (long i = 0; i < n; ++i) {
+			mvecs[j][i] *= mvecs[j][i];
+		}
+		complex<double>* dvec = scheme.decrypt(secretKey, unpacked[j]);
+		StringUtils::compare(mvecs[j], dvec, n, "unpack");
+		delete[] dvec;
+	}
+
+	cout << "!!! END TEST PACK !!!" << endl;
+}
+
 
 //----------------------------------------------------------------------------------
 //   POWER & PRODUCT TESTS
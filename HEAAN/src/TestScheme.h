@@ -20,11 +20,31 @@ public:
 	static void testEncrypt(long logq, long logp, long logn);
 	
 	static void testEncryptSingle(long logq, long logp);
+
+	static void testEncryptBatch(long logq, long logp, long logn, long count);
+
+	static void testEncryptionPool(long logq, long logp, long logn, long count);
+
+	static void testEncryptSymmetric(long logq, long logp, long logn);
 	
 	static void testAdd(long logq, long logp, long logn);
+
+	static void testSumMany(long logq, long logp, long logn, long count);
 	
 	static void testMult(long logq, long logp, long logn);
+
+	static void testMultNoRelin(long logq, long logp, long logn, long count);
+
+	static void testInnerProduct(long logq, long logp, long logn, long count);
+
+	static void testMultByPlaintextNTT(long logq, long logp, long logn, long count);
+
+	static void testMultByConstVec(long logq, long logp, long logn, long count);
+
+	static void testMultByConst(long logq, long logp, long logn);
 	
+	static void testTwoReal(long logq, long logp, long logn);
+
 	static void testiMult(long logq, long logp, long logn);
 
 
@@ -37,6 +57,28 @@ public:
 
 	static void testConjugate(long logq, long logp, long logn);
 
+	static void testRotateFastNTT(long logq, long logp, long logn, long r);
+
+	static void testSumSlots(long logq, long logp, long logn);
+
+
+	//----------------------------------------------------------------------------------
+	//   LINEAR ALGEBRA TESTS
+	//----------------------------------------------------------------------------------
+
+
+	static void testLinearTransform(long logq, long logp, long logn);
+
+	static void testPermute(long logq, long logp, long logn);
+
+	static void testMatMul(long logq, long logp, long logd);
+
+	static void testConvolution(long logq, long logp, long logn, long stride);
+
+	static void testDFT(long logq, long logp, long logn);
+
+	static void testPack(long logq, long logp, long logn, long count);
+
 
 	//----------------------------------------------------------------------------------
 	//   POWER & PRODUCT TESTS